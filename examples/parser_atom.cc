@@ -83,6 +83,10 @@ static std::ostream &operator<<(std::ostream &stream,
 }
 
 int main(int argc, char *argv[]) {
+    feed::set_log_handler([](feed::log_level, const std::string &message) {
+        std::cerr << "Error: " << message << '\n';
+    });
+
     feed::utility::xml xml;
 
     const auto xml_str = xml.to_string("https://ohmyarch.github.io/atom.xml");
@@ -55,6 +55,10 @@ static void open_url(const std::string &uri) {
 }
 
 int main(int argc, char *argv[]) {
+    feed::set_log_handler([](feed::log_level, const std::string &message) {
+        std::cerr << "Error: " << message << '\n';
+    });
+
     feed::utility::xml xml;
 
     const auto xml_str = xml.to_string("https://ipn.li/kernelpanic/feed");
@@ -29,7 +29,11 @@
 #pragma once
 
 #include <vector>
+#include <feed/extension.h>
+#include <feed/feed_state.h>
 #include <feed/link.h>
+#include <feed/parse_options.h>
+#include <functional>
 
 namespace feed {
 namespace atom {
@@ -46,10 +50,13 @@ class text {
     const std::string &value() const { return value_; }
     type type() const { return type_; }
 
+    std::size_t memory_usage() const { return detail::heap_bytes_of(value_); }
+
   private:
+    friend class detail::codec;
     friend class entry;
     friend class atom_data;
-    friend boost::optional<atom_data> parse_atom(const std::string &xml_str);
+    friend class parser;
 
     text() : type_(type::text) {}
 
@@ -72,7 +79,13 @@ class person {
     const boost::optional<std::string> &email() const { return email_; }
     const boost::optional<std::string> &uri() const { return uri_; }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(name_, email_, uri_);
+    }
+
   private:
+    friend class detail::codec;
+
     std::string name_; // Conveys a human-readable name for the person.
     boost::optional<std::string> email_; // Contains a home page for the person.
     boost::optional<std::string>
@@ -94,7 +107,13 @@ class category {
     const boost::optional<std::string> &scheme() const { return scheme_; }
     const boost::optional<std::string> &label() const { return label_; }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(term_, scheme_, label_);
+    }
+
   private:
+    friend class detail::codec;
+
     std::string term_;
     boost::optional<std::string> scheme_;
     boost::optional<std::string> label_;
@@ -116,7 +135,13 @@ class generator {
     const boost::optional<std::string> &uri() const { return uri_; }
     const boost::optional<std::string> &version() const { return version_; }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(value_, uri_, version_);
+    }
+
   private:
+    friend class detail::codec;
+
     std::string value_;
     boost::optional<std::string> uri_;
     boost::optional<std::string> version_;
@@ -133,7 +158,8 @@ class entry {
           summary_(std::move(other.summary_)),
           categories_(std::move(other.categories_)),
           rights_(std::move(other.rights_)),
-          contributors_(std::move(other.contributors_)) {}
+          contributors_(std::move(other.contributors_)),
+          extensions_(std::move(other.extensions_)) {}
 
     const std::string &id() const { return id_; }
     const text &title() const { return title_; }
@@ -150,9 +176,21 @@ class entry {
     const boost::optional<std::vector<person>> &contributors() const {
         return contributors_;
     }
+    // Elements from the namespaces registered in parse_options::extensions.
+    const boost::optional<std::vector<extension>> &extensions() const {
+        return extensions_;
+    }
+
+    // Heap bytes retained by the entry, see detail::heap_bytes().
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(
+            id_, title_, authors_, content_, links_, summary_, categories_,
+            rights_, contributors_, extensions_);
+    }
 
   private:
-    friend boost::optional<atom_data> parse_atom(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     entry() {}
 
@@ -172,6 +210,7 @@ class entry {
                                    // copyrights, held in and over the entry.
     boost::optional<std::vector<person>>
         contributors_; // Names contributors to the entry.
+    boost::optional<std::vector<extension>> extensions_;
 };
 
 class atom_data {
@@ -188,7 +227,9 @@ class atom_data {
           logo_(std::move(other.logo_)),
           rights_(std::move(other.rights_)),
           subtitle_(std::move(other.subtitle_)),
-          entries_(std::move(other.entries_)) {}
+          entries_(std::move(other.entries_)),
+          extensions_(std::move(other.extensions_)),
+          valid_utf8_(other.valid_utf8_) {}
 
     const std::string &id() const { return id_; }
     const text &title() const { return title_; }
@@ -210,9 +251,25 @@ class atom_data {
     const boost::optional<text> &rights() const { return rights_; }
     const boost::optional<text> &subtitle() const { return subtitle_; }
     const std::vector<entry> &entries() const { return entries_; }
+    // Elements from the namespaces registered in parse_options::extensions.
+    const boost::optional<std::vector<extension>> &extensions() const {
+        return extensions_;
+    }
+    // Whether every string of the feed is known to be valid UTF-8, see
+    // parse_options::utf8.
+    bool valid_utf8() const { return valid_utf8_; }
+
+    // Heap bytes retained by the feed, sizeof(atom_data) not included.
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(
+            id_, title_, authors_, links_, categories_, contributors_,
+            generator_, icon_, logo_, rights_, subtitle_, entries_,
+            extensions_);
+    }
 
   private:
-    friend boost::optional<atom_data> parse_atom(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     atom_data() {}
 
@@ -239,8 +296,38 @@ class atom_data {
     boost::optional<text> subtitle_; // Contains a human-readable description or
     // subtitle for the feed.
     std::vector<entry> entries_;
+    boost::optional<std::vector<extension>> extensions_;
+    bool valid_utf8_ = false;
 };
 
 boost::optional<atom_data> parse_atom(const std::string &xml_str);
+boost::optional<atom_data> parse_atom(const std::string &xml_str,
+                                      parse_stats &stats);
+boost::optional<atom_data> parse_atom(const std::string &xml_str,
+                                      const parse_options &options);
+// The result of parse_atom() against the state of a previous poll, see
+// rss_delta.
+struct atom_delta {
+    explicit atom_delta(atom_data &&feed) : data(std::move(feed)) {}
+
+    atom_data data;
+    std::vector<std::size_t> changed; // Indices in data.entries().
+    std::size_t unchanged = 0;
+    feed_state state;
+};
+
+// Entries of previous whose bytes are the same are skipped without being
+// built, see the equivalent parse_rss().
+boost::optional<atom_delta> parse_atom(const std::string &xml_str,
+                                       const feed_state &previous,
+                                       const parse_options &options =
+                                           parse_options());
+// Hands each entry to on_entry as soon as it is built instead of keeping it,
+// see the equivalent parse_rss(). on_feed receives the feed without entries,
+// last, and what on_entry throws is rethrown.
+bool parse_atom(const std::string &xml_str,
+                const std::function<void(atom_data &&)> &on_feed,
+                const std::function<bool(entry &&)> &on_entry,
+                const parse_options &options = parse_options());
 }
 }
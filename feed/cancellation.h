@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace feed {
+namespace detail {
+struct cancellation_state {
+    std::atomic<bool> cancelled{false};
+    std::mutex mutex;
+    std::size_t next_id = 1;
+    std::vector<std::pair<std::size_t, std::function<void()>>> callbacks;
+};
+}
+
+// Observes a cancellation_source. Fetches and parses given a token stop early
+// once its source is cancelled. Copies observe the same source.
+class cancellation_token {
+  public:
+    // A token that is never cancelled.
+    cancellation_token() = default;
+
+    bool cancelled() const {
+        return state_ && state_->cancelled.load(std::memory_order_acquire);
+    }
+    // False for a default-constructed token.
+    bool cancellable() const { return static_cast<bool>(state_); }
+
+    // Calls callback, on the thread that cancels, once the source is
+    // cancelled, right away if it already is. Returns an id for
+    // unsubscribe(), 0 if callback has been or will never be called.
+    std::size_t subscribe(std::function<void()> callback) const;
+    void unsubscribe(std::size_t id) const;
+
+  private:
+    friend class cancellation_source;
+
+    explicit cancellation_token(
+        std::shared_ptr<detail::cancellation_state> state)
+        : state_(std::move(state)) {}
+
+    std::shared_ptr<detail::cancellation_state> state_;
+};
+
+// Cancels the work given its tokens, e.g. a batch of fetches.
+class cancellation_source {
+  public:
+    cancellation_source()
+        : state_(std::make_shared<detail::cancellation_state>()) {}
+
+    cancellation_token token() const { return cancellation_token(state_); }
+    // Idempotent, the callbacks run once.
+    void cancel();
+    bool cancelled() const {
+        return state_->cancelled.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::shared_ptr<detail::cancellation_state> state_;
+};
+}
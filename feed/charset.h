@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace feed {
+// The single-byte charsets transcoded to UTF-8 while parsing. Documents in
+// other charsets are parsed as UTF-8.
+enum class charset : std::uint8_t { utf8, iso_8859_1, windows_1252 };
+
+// Looks up an IANA charset name or alias, e.g. "ISO-8859-1", "latin1" or
+// "cp1252", ignoring case. US-ASCII is reported as UTF-8, its superset.
+boost::optional<charset> find_charset(boost::string_ref name);
+
+// The encoding of the XML declaration at the start of a document, empty if
+// there is none.
+boost::string_ref declared_encoding(boost::string_ref document);
+
+// Appends input, in charset from, converted to UTF-8.
+void to_utf8(charset from, boost::string_ref input, std::string &out);
+
+// Length of the run of ASCII bytes data starts with, checked 16 or 8 bytes at
+// a time.
+std::size_t ascii_length(const char *data, std::size_t size);
+
+// Length of the longest prefix of data that is well-formed UTF-8, i.e. size
+// if it all is. Overlong forms, surrogates and code points past U+10FFFF are
+// ill-formed. ASCII runs are skipped as in ascii_length().
+std::size_t utf8_length(const char *data, std::size_t size);
+
+// Appends input with each maximal subpart of an ill-formed sequence replaced
+// by U+FFFD, as the Unicode standard recommends and WHATWG decoders do: a
+// truncated sequence by one, an overlong form or a surrogate by one per
+// byte.
+void repair_utf8(boost::string_ref input, std::string &out);
+}
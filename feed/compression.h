@@ -0,0 +1,70 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace feed {
+// Streaming zlib inflation of gzip, zlib or raw deflate data, the format is
+// told from the first bytes. Concatenated gzip members are inflated one after
+// the other, as gunzip does.
+class inflater {
+  public:
+    inflater();
+    inflater(const inflater &) = delete;
+    ~inflater();
+
+    inflater &operator=(const inflater &) = delete;
+
+    // Appends what size bytes of input inflate to, returns false on corrupt
+    // input, after which the inflater is unusable. With max_size, also stops
+    // and returns false once out holds more than max_size bytes.
+    bool inflate(const void *data, std::size_t size, std::string &out,
+                 std::size_t max_size = 0);
+    // Whether the input seen so far ends a complete stream.
+    bool finished() const;
+
+  private:
+    struct state;
+
+    std::unique_ptr<state> state_;
+};
+
+// Whether data starts with the gzip magic number.
+bool is_gzip(const void *data, std::size_t size);
+
+// Reads a feed document from disk, inflating it on the fly if it is gzip
+// compressed, e.g. a .gz archive. Fails past max_size bytes of content, 0 for
+// no limit, e.g. parse_limits::max_document_bytes.
+boost::optional<std::string> read_file(const std::string &path,
+                                       std::size_t max_size = 0);
+}
@@ -0,0 +1,188 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <feed/memory_usage.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace feed {
+namespace detail {
+class codec;
+class parse_context;
+}
+
+// Namespaces commonly found in feeds.
+namespace xmlns {
+const char *const atom = "http://www.w3.org/2005/Atom";
+const char *const atom03 = "http://purl.org/atom/ns#";
+const char *const content = "http://purl.org/rss/1.0/modules/content/";
+const char *const dc = "http://purl.org/dc/elements/1.1/";
+const char *const itunes = "http://www.itunes.com/dtds/podcast-1.0.dtd";
+const char *const media = "http://search.yahoo.com/mrss/";
+const char *const podcast = "https://podcastindex.org/namespace/1.0";
+const char *const sy = "http://purl.org/rss/1.0/modules/syndication/";
+}
+
+// An element from a namespace registered in an extension_registry, e.g.
+// content:encoded or media:content, as found in the channel, an item, the feed
+// or an entry.
+class extension {
+  public:
+    extension(const extension &other)
+        : namespace_uri_(other.namespace_uri_), name_(other.name_),
+          attributes_(other.attributes_), value_(other.value_),
+          children_(other.children_) {}
+    extension(extension &&other) noexcept
+        : namespace_uri_(std::move(other.namespace_uri_)),
+          name_(std::move(other.name_)),
+          attributes_(std::move(other.attributes_)),
+          value_(std::move(other.value_)),
+          children_(std::move(other.children_)) {}
+
+    const std::string &namespace_uri() const { return namespace_uri_; }
+    // The local name, without the prefix.
+    const std::string &name() const { return name_; }
+    // Attribute names as written in the document, namespace declarations
+    // excluded.
+    const std::vector<std::pair<std::string, std::string>> &
+    attributes() const {
+        return attributes_;
+    }
+    boost::optional<const std::string &>
+    attribute(boost::string_ref name) const {
+        for (const auto &attribute : attributes_)
+            if (attribute.first == name)
+                return attribute.second;
+
+        return {};
+    }
+    // The character data directly inside the element.
+    const std::string &value() const { return value_; }
+    const std::vector<extension> &children() const { return children_; }
+
+    std::size_t memory_usage() const {
+        std::size_t bytes = detail::heap_bytes_of(namespace_uri_, name_,
+                                                  value_, children_) +
+                            attributes_.capacity() * sizeof(attributes_[0]);
+        for (const auto &attribute : attributes_)
+            bytes += detail::heap_bytes_of(attribute.first, attribute.second);
+
+        return bytes;
+    }
+
+    extension &operator=(extension &&other) noexcept {
+        if (&other != this) {
+            namespace_uri_ = std::move(other.namespace_uri_);
+            name_ = std::move(other.name_);
+            attributes_ = std::move(other.attributes_);
+            value_ = std::move(other.value_);
+            children_ = std::move(other.children_);
+        }
+
+        return *this;
+    }
+
+  private:
+    friend class detail::codec;
+    friend class detail::parse_context;
+
+    extension() {}
+
+    std::string namespace_uri_;
+    std::string name_;
+    std::vector<std::pair<std::string, std::string>> attributes_;
+    std::string value_;
+    std::vector<extension> children_;
+};
+
+// The first extension element called name in namespace_uri, if any.
+inline const extension *
+find_extension(const boost::optional<std::vector<extension>> &extensions,
+               boost::string_ref namespace_uri, boost::string_ref name) {
+    if (extensions)
+        for (const auto &element : extensions.value())
+            if (element.namespace_uri() == namespace_uri &&
+                element.name() == name)
+                return &element;
+
+    return nullptr;
+}
+
+// Selects the foreign namespaces whose elements parse_rss() and parse_atom()
+// keep as extensions. Namespaces are matched by URI, whatever prefix a feed
+// binds them to, and the elements are collected in the same pass that parses
+// the rest of the document.
+class extension_registry {
+  public:
+    // Called with each element of its namespace once it has been parsed, the
+    // element is kept if it returns true.
+    using handler = std::function<bool(extension &element)>;
+
+    // Keeps the elements of namespace_uri, filtered by handler if given.
+    void add(std::string namespace_uri, handler handler = nullptr) {
+        remove(namespace_uri);
+        handlers_.emplace_back(std::move(namespace_uri), std::move(handler));
+    }
+    void remove(boost::string_ref namespace_uri) {
+        for (auto it = handlers_.begin(); it != handlers_.end(); ++it)
+            if (it->first == namespace_uri) {
+                handlers_.erase(it);
+
+                return;
+            }
+    }
+    // Null if namespace_uri is not registered.
+    const handler *find(boost::string_ref namespace_uri) const {
+        for (const auto &entry : handlers_)
+            if (entry.first == namespace_uri)
+                return &entry.second;
+
+        return nullptr;
+    }
+
+    // content, dc, itunes, media, podcast and sy.
+    static extension_registry common() {
+        extension_registry registry;
+        for (const char *uri : {xmlns::content, xmlns::dc, xmlns::itunes,
+                                xmlns::media, xmlns::podcast, xmlns::sy})
+            registry.add(uri);
+
+        return registry;
+    }
+
+  private:
+    // A handful of namespaces at most, a vector beats hashing here.
+    std::vector<std::pair<std::string, handler>> handlers_;
+};
+}
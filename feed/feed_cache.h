@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <feed/atom_parser.h>
+#include <feed/fetcher.h>
+#include <feed/rss_parser.h>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace feed {
+struct feed_cache_config {
+    // Bound on the bytes held, the memory_usage() of each feed plus its size
+    // and URL. The least recently used feeds are evicted beyond it, a feed
+    // larger than it is not kept.
+    std::size_t max_bytes = 64 * 1024 * 1024;
+    // How long a feed is fresh when it has no ttl, which Atom feeds never do.
+    std::chrono::seconds default_ttl{15 * 60};
+    // Caps the ttl of a feed.
+    std::chrono::seconds max_ttl{24 * 60 * 60};
+};
+
+// Parsed feeds by URL, shared and immutable, so that the users of a process
+// fetch and parse a feed once between them. Safe to share between threads.
+// Instantiated for rss::rss_data and atom::atom_data.
+//
+// A feed is fresh for its ttl once cached. Feeds no longer fresh stay until
+// evicted, a not_modified response then makes them fresh again.
+template <typename Feed> class feed_cache {
+  public:
+    using clock = std::chrono::steady_clock;
+    using feed_ptr = std::shared_ptr<const Feed>;
+    // Loads the feed of uri, null if it cannot.
+    using loader = std::function<pplx::task<feed_ptr>(const std::string &uri)>;
+
+    explicit feed_cache(feed_cache_config config = feed_cache_config());
+    feed_cache(const feed_cache &) = delete;
+    feed_cache &operator=(const feed_cache &) = delete;
+
+    // The feed of uri if it is fresh, null otherwise.
+    feed_ptr find(const std::string &uri);
+    // Does nothing if feed is null.
+    void insert(const std::string &uri, feed_ptr feed);
+
+    // The feed of uri if it is fresh, otherwise the one load returns, which
+    // is then cached. Calls for uri while it is being loaded wait for that
+    // load rather than start another. The cache must outlive the loads it
+    // starts.
+    pplx::task<feed_ptr> get_async(const std::string &uri, const loader &load);
+    // With fetcher::fetch_and_parse_async() as the loader, conditional only
+    // if the feed is still cached. If the fetch fails or times out, the feed
+    // still cached is returned, and fresh again for its ttl so that callers
+    // do not all retry a failing server. fetcher, and what options points to,
+    // must outlive the task.
+    pplx::task<feed_ptr>
+    get_async(const std::string &uri, fetcher &fetcher,
+              const parse_options &options = parse_options(),
+              const fetch_options &fetch = fetch_options());
+
+    bool erase(const std::string &uri);
+    void clear();
+    std::size_t size() const;
+    std::size_t bytes() const;
+
+  private:
+    struct entry {
+        std::string uri;
+        feed_ptr feed;
+        std::size_t bytes;
+        clock::time_point expires;
+    };
+    using entry_list = std::list<entry>;
+
+    // The feed of uri and whether it is fresh, moved to the front.
+    feed_ptr lookup(const std::string &uri, bool &fresh);
+    void store(const std::string &uri, feed_ptr feed);
+
+    const feed_cache_config config_;
+    mutable std::mutex mutex_;
+    entry_list entries_; // The most recently used first.
+    std::unordered_map<std::string, typename entry_list::iterator> index_;
+    std::unordered_map<std::string, pplx::task<feed_ptr>> loading_;
+    std::size_t bytes_ = 0;
+};
+
+extern template class feed_cache<rss::rss_data>;
+extern template class feed_cache<atom::atom_data>;
+}
@@ -0,0 +1,61 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace feed {
+// The items of a feed at the last poll, as 64-bit hashes: of the guid, link
+// if it has none, or Atom id of each item, and of the item's bytes as they
+// were in the document. 16 bytes per item, see parse_rss() with a
+// feed_state.
+class feed_state {
+  public:
+    using entry = std::pair<std::uint64_t, std::uint64_t>; // Key, content.
+
+    feed_state() = default;
+    // From entries() as stored by the caller. Sorted by key, the first of
+    // duplicate keys is kept.
+    explicit feed_state(std::vector<entry> entries);
+
+    // The content hash of the item whose key hash is key.
+    boost::optional<std::uint64_t> find(std::uint64_t key) const;
+
+    // Sorted by key.
+    const std::vector<entry> &entries() const { return entries_; }
+    std::size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+  private:
+    std::vector<entry> entries_;
+};
+}
@@ -0,0 +1,237 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cpprest/http_client.h>
+#include <cstdint>
+#include <feed/cancellation.h>
+#include <feed/parse_options.h>
+#include <feed/validator_cache.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace feed {
+enum class fetch_status : std::uint8_t {
+    ok,           // body holds the document.
+    not_modified, // The server answered 304 to a conditional request, or
+                  // the body did not change, see fetcher_config::fingerprints.
+    failed,       // See the log for the reason.
+    timed_out,    // A deadline of fetch_options was reached.
+    cancelled     // fetch_options::cancel was cancelled.
+};
+
+struct fetch_result {
+    fetch_status status = fetch_status::failed;
+    std::uint16_t status_code = 0; // 0 if no response was received.
+    std::string content_type;
+    // From content_type, lower-cased, empty if not declared. body holds the
+    // bytes as received, in this charset.
+    std::string charset;
+    std::string body;
+    // Stopped at a known item, see fetch_options::known_item.
+    bool partial = false;
+    // normalized_fingerprint() of body, if fetcher_config::fingerprints is
+    // set and the body is not partial.
+    std::uint64_t fingerprint = 0;
+
+    explicit operator bool() const { return status == fetch_status::ok; }
+};
+
+// A fetch_result whose body went through a parser, see
+// fetcher::fetch_and_parse_async().
+template <typename Feed> struct parsed_fetch {
+    // ok only if feed is set, a document that fails to parse is failed.
+    fetch_status status = fetch_status::failed;
+    std::uint16_t status_code = 0;
+    // Shared since task results are copied, and atom_data cannot be.
+    std::shared_ptr<const Feed> feed;
+};
+
+struct fetcher_config {
+    // Hosts, i.e. scheme, host and port, whose client and idle keep-alive
+    // connections are kept. Beyond that the least recently used is closed.
+    std::size_t max_hosts = 64;
+    // Clients unused for this long are closed on the next fetch.
+    std::chrono::seconds idle_timeout{300};
+    std::chrono::seconds timeout{30};
+    boost::optional<std::string> proxy;
+    std::string user_agent = "feed_parser";
+    bool validate_certificates = true;
+    // Sends Accept-Encoding: gzip, deflate and inflates compressed bodies as
+    // they are received.
+    bool compression = true;
+    // When set, requests carry If-None-Match and If-Modified-Since from the
+    // previous fetch of the same URL and a 304 yields
+    // fetch_status::not_modified instead of a body.
+    std::shared_ptr<validator_cache> validators;
+    // With validators, a 200 whose body has the same normalized_fingerprint()
+    // as the previous one of the URL also yields fetch_status::not_modified,
+    // without a body. For servers that send no validators or regenerate the
+    // feed on each request.
+    bool fingerprints = false;
+
+    // Requests in flight per host, 0 for no limit, each until its body is
+    // read. Requests beyond it wait in a queue of their host.
+    std::size_t max_requests_per_host = 0;
+    // Rate of requests per host, 0 for no limit, enforced by a token bucket
+    // holding up to burst requests.
+    double requests_per_second = 0;
+    std::size_t burst = 1;
+    // Longest pause of a host asked by a Retry-After.
+    std::chrono::seconds max_retry_after{60 * 60};
+};
+
+// Limits of a single fetch, zero for none. They come on top of
+// fetcher_config::timeout, which cpprest applies to each network operation.
+struct fetch_options {
+    // From the start of the request, once its host allows it, until the
+    // response headers are in, connecting included, cpprest does not report
+    // when the connection is established.
+    std::chrono::milliseconds connect_timeout{0};
+    // Between two chunks of the body, so that a server trickling it out
+    // cannot hold the request.
+    std::chrono::milliseconds read_timeout{0};
+    // For the whole fetch, from the call, waiting for the host and parsing
+    // in fetch_and_parse_async() included.
+    std::chrono::milliseconds total_timeout{0};
+    cancellation_token cancel;
+    // Called, on a pplx thread, with the guid, the link if it has none, of
+    // each item of the body as it arrives, or the id of each Atom entry.
+    // Returning true closes the connection there: the body then ends right
+    // before that item, its open elements closed, and fetch_result::partial
+    // is set. Elements following the items are lost.
+    std::function<bool(const std::string &)> known_item;
+    // False to leave out the validators and fingerprint of
+    // fetcher_config::validators, for a body even if the feed did not change.
+    bool conditional = true;
+    // Bytes of the body once inflated, 0 for no limit. The fetch fails as
+    // soon as more arrive, so that a small compressed body cannot expand
+    // without bound. fetch_and_parse_async() uses
+    // parse_limits::max_document_bytes unless it is set.
+    std::size_t max_body_bytes = 0;
+};
+
+// Downloads feeds, reusing one http_client, and so its connections, per host
+// across calls. The configuration is fixed at construction, a single fetcher
+// is meant to be shared by all the threads of a process.
+//
+// With per-host limits, requests that cannot start wait in a queue of their
+// host, a slow host only delays its own. A dispatcher thread starts them as
+// soon as their host allows, going round the waiting hosts one request at a
+// time. A 429 or 503 with a Retry-After in seconds pauses its host as asked,
+// up to fetcher_config::max_retry_after.
+// The same thread enforces the deadlines of fetch_options.
+class fetcher {
+  public:
+    explicit fetcher(fetcher_config config = fetcher_config());
+    fetcher(const fetcher &) = delete;
+    // Queued requests fail, those in flight complete without deadlines.
+    ~fetcher();
+
+    fetcher &operator=(const fetcher &) = delete;
+
+    // Blocks until fetch_async() completes.
+    fetch_result fetch(const std::string &uri,
+                       const fetch_options &options = fetch_options());
+    // Completes on a pplx thread once the body has been received, without
+    // holding a thread while the request is in flight. Never throws from
+    // get(), failures are reported as fetch_status::failed.
+    pplx::task<fetch_result>
+    fetch_async(const std::string &uri,
+                const fetch_options &options = fetch_options());
+    // Runs parser, e.g.
+    //
+    //     [](const std::string &xml, const feed::parse_options &options) {
+    //         return feed::rss::parse_rss(xml, options);
+    //     }
+    //
+    // on the body in the continuation that receives it, with options whose
+    // charset is the one of the response. Unless options has its own, the
+    // parse gets the cancellation token and total deadline of fetch. What
+    // options points to must outlive the task.
+    template <typename Parser>
+    auto fetch_and_parse_async(const std::string &uri, Parser parser,
+                               parse_options options = parse_options(),
+                               const fetch_options &fetch = fetch_options())
+        -> pplx::task<parsed_fetch<typename decltype(
+            parser(std::string(), options))::value_type>> {
+        using feed_type =
+            typename decltype(parser(std::string(), options))::value_type;
+
+        if (!options.cancel.cancellable())
+            options.cancel = fetch.cancel;
+        if (!options.deadline && fetch.total_timeout.count() != 0)
+            options.deadline =
+                std::chrono::steady_clock::now() + fetch.total_timeout;
+
+        auto bounded = fetch;
+        if (bounded.max_body_bytes == 0)
+            bounded.max_body_bytes = options.limits.max_document_bytes;
+
+        return fetch_async(uri, bounded).then([parser, options](
+            fetch_result fetched) {
+            parsed_fetch<feed_type> parsed;
+            parsed.status = fetched.status;
+            parsed.status_code = fetched.status_code;
+            if (fetched) {
+                auto with_charset = options;
+                with_charset.charset = std::move(fetched.charset);
+                auto feed = parser(fetched.body, with_charset);
+                if (feed)
+                    parsed.feed =
+                        std::make_shared<const feed_type>(std::move(*feed));
+                else if (options.cancel.cancelled())
+                    parsed.status = fetch_status::cancelled;
+                else if (options.deadline &&
+                         std::chrono::steady_clock::now() >=
+                             options.deadline.value())
+                    parsed.status = fetch_status::timed_out;
+                else
+                    parsed.status = fetch_status::failed;
+            }
+
+            return parsed;
+        });
+    }
+
+    // Number of hosts with a client in the pool.
+    std::size_t hosts() const;
+    // Closes the pooled clients without requests in flight or queued.
+    void clear();
+
+  private:
+    struct pool;
+
+    // Shared with the continuations of the requests in flight.
+    std::shared_ptr<pool> pool_;
+};
+}
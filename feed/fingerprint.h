@@ -0,0 +1,46 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <cstdint>
+
+namespace feed {
+// hash64() of the document as received.
+std::uint64_t raw_fingerprint(boost::string_ref document);
+
+// hash64() of the document without what changes when a feed is regenerated
+// with the same content: the lastBuildDate elements, the pubDate and Atom
+// updated elements ahead of the first item or entry, i.e. those of the
+// channel or feed, whitespace next to tags and the length of other runs of
+// whitespace. Atom elements are matched in the default namespace or under a
+// prefix bound to Atom in the head, RSS ones without a prefix.
+// Two documents with the same fingerprint are taken to hold the same items.
+std::uint64_t normalized_fingerprint(boost::string_ref document);
+}
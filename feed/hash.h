@@ -0,0 +1,63 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <feed/atom_parser.h>
+#include <feed/rss_parser.h>
+
+namespace feed {
+// XXH64 of data: several GB/s and well distributed, but not meant to resist
+// deliberate collisions.
+std::uint64_t hash64(boost::string_ref data, std::uint64_t seed = 0);
+
+// hash64() of data given in pieces: the digest of the concatenation of what
+// update() was given.
+class hasher {
+  public:
+    explicit hasher(std::uint64_t seed = 0);
+
+    hasher &update(boost::string_ref data);
+    std::uint64_t digest() const;
+
+  private:
+    std::uint64_t seed_;
+    std::uint64_t lanes_[4];
+    std::uint64_t length_ = 0;
+    char buffer_[32];
+    std::size_t buffered_ = 0;
+};
+
+// The identity of an item for deduplication: its guid, its link if it has
+// none, empty if it has neither. An Atom entry's is its id.
+boost::string_ref identity(const rss::item &item);
+boost::string_ref identity(const atom::entry &entry);
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <feed/atom_parser.h>
+#include <feed/rss_parser.h>
+#include <vector>
+
+namespace feed {
+// What an interval_estimator remembers of a feed between polls, 40 bytes.
+struct arrival_history {
+    std::int64_t newest = 0;        // Seconds since the epoch of the newest
+                                    // dated item seen, 0 before.
+    std::int64_t polled = 0;        // Seconds since the epoch of the last poll
+                                    // that found items, 0 before the first.
+    std::uint64_t front_id = 0;     // Hashes of the guid, id or link of the
+    std::uint64_t back_id = 0;      // first and last items it listed.
+    float mean_gap = 0;             // Smoothed seconds between items.
+    std::uint16_t idle_polls = 0;   // Polls in a row without a new item.
+    std::uint16_t samples = 0;      // Gaps seen, saturating.
+};
+
+static_assert(sizeof(arrival_history) == 40,
+              "arrival_history is meant to be 40 bytes");
+
+struct estimator_config {
+    std::chrono::seconds min_interval{5 * 60};
+    std::chrono::seconds max_interval{24 * 60 * 60};
+    // Until a feed has shown enough gaps.
+    std::chrono::seconds default_interval{60 * 60};
+    std::uint16_t min_samples = 3;
+    // Weight of the latest gap in the mean, higher reacts faster to bursts.
+    float smoothing = 0.3f;
+    // Polls per expected item, above 1 to catch items soon after they appear.
+    float polls_per_item = 2;
+    // Each poll without a new item multiplies the interval by this, up to
+    // max_interval, so dormant feeds are polled less and less often.
+    float backoff = 1.5f;
+};
+
+// Proposes poll intervals from the arrival times of new items. Dated items give
+// a gap each, the k undated ones found by a poll share the time since the last
+// poll that found items, and undated items of the first poll teach nothing.
+// Items are new if they are listed outside the first and last items of the
+// previous poll, so feeds may list the newest first or last.
+class interval_estimator {
+  public:
+    using clock = std::chrono::system_clock;
+
+    explicit interval_estimator(estimator_config config = estimator_config());
+
+    // Updates history with a poll made at at, returns the number of new
+    // items.
+    std::size_t observe(arrival_history &history, const rss::rss_data &feed,
+                        clock::time_point at = clock::now()) const;
+    // Atom entries carry no dates here, they arrive when they are seen.
+    std::size_t observe(arrival_history &history, const atom::atom_data &feed,
+                        clock::time_point at = clock::now()) const;
+    // A poll that found nothing new, e.g. fetch_status::not_modified.
+    void unchanged(arrival_history &history) const;
+
+    // The proposed interval, see poll_hints::estimate.
+    std::chrono::seconds interval(const arrival_history &history) const;
+
+  private:
+    struct item {
+        std::uint64_t id;
+        std::int64_t time; // 0 if undated.
+    };
+
+    void sample(arrival_history &history, float gap) const;
+
+    std::size_t learn(arrival_history &history, const std::vector<item> &items,
+                      std::int64_t now) const;
+
+    const estimator_config config_;
+};
+}
@@ -29,13 +29,16 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <feed/memory_usage.h>
 #include <string>
 
 namespace feed {
-namespace rss {
-class rss_data;
+namespace detail {
+class codec;
+}
 
-boost::optional<rss_data> parse_rss(const std::string &xml_str);
+namespace rss {
+class parser;
 }
 
 namespace atom {
@@ -49,7 +52,7 @@ enum class rel : std::uint8_t {
         // publisher.
 };
 
-class atom_data;
+class parser;
 
 class link {
   public:
@@ -84,10 +87,14 @@ class link {
         return *this;
     }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(href_, href_lang_, title_, type_);
+    }
+
   private:
-    friend boost::optional<rss::rss_data>
-    rss::parse_rss(const std::string &xml_str);
-    friend boost::optional<atom_data> parse_atom(const std::string &xml_str);
+    friend class detail::codec;
+    friend class rss::parser;
+    friend class parser;
 
     link() {}
 
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace feed {
+enum class log_level : std::uint8_t { debug, info, warning, error };
+
+using log_handler = std::function<void(log_level, const std::string &)>;
+
+// Routes the library's diagnostics to handler. Messages below level are
+// dropped, and so are messages beyond max_per_second when it is not zero, in
+// which case the number of dropped messages is reported with the first
+// message of a later second; both counts are exact across threads. Without a
+// handler, the default, the library stays silent.
+//
+// The handler is called on the thread that hit the problem and must be safe to
+// call concurrently, see async_log_handler to move the work elsewhere.
+void set_log_handler(log_handler handler,
+                     log_level level = log_level::warning,
+                     std::uint32_t max_per_second = 0);
+
+bool log_enabled(log_level level);
+void log(log_level level, const std::string &message);
+
+// Hands messages over to a background thread that calls target, so the
+// logging thread never waits on I/O. When capacity messages are queued, new
+// ones are dropped and counted.
+//
+//     auto sink = std::make_shared<feed::async_log_handler>(write_to_file);
+//     feed::set_log_handler([sink](feed::log_level level,
+//                                  const std::string &message) {
+//         (*sink)(level, message);
+//     });
+class async_log_handler {
+  public:
+    explicit async_log_handler(log_handler target,
+                               std::size_t capacity = 1024);
+    async_log_handler(const async_log_handler &) = delete;
+    ~async_log_handler(); // Delivers what is queued, then joins.
+
+    async_log_handler &operator=(const async_log_handler &) = delete;
+
+    void operator()(log_level level, const std::string &message);
+
+    std::uint64_t dropped() const;
+
+  private:
+    void run();
+
+    log_handler target_;
+    std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::pair<log_level, std::string>> queue_;
+    std::uint64_t dropped_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+}
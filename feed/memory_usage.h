@@ -0,0 +1,92 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <chrono>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace feed {
+namespace detail {
+// Bytes requested from the allocator for what a value owns on the heap, the
+// value itself and the allocator's own overhead not included. Class types
+// report theirs through memory_usage().
+inline std::size_t heap_bytes(const std::string &str) {
+    // Strings up to the capacity of an empty one are stored inline.
+    static const std::size_t inline_capacity = std::string().capacity();
+
+    return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+}
+
+template <typename Clock, typename Duration>
+std::size_t heap_bytes(const std::chrono::time_point<Clock, Duration> &) {
+    return 0;
+}
+
+template <typename T>
+typename std::enable_if<std::is_scalar<T>::value, std::size_t>::type
+heap_bytes(const T &) {
+    return 0;
+}
+
+template <typename T>
+typename std::enable_if<std::is_class<T>::value, std::size_t>::type
+heap_bytes(const T &value);
+template <typename T> std::size_t heap_bytes(const std::vector<T> &vector);
+template <typename T> std::size_t heap_bytes(const boost::optional<T> &value);
+
+template <typename T>
+typename std::enable_if<std::is_class<T>::value, std::size_t>::type
+heap_bytes(const T &value) {
+    return value.memory_usage();
+}
+
+template <typename T> std::size_t heap_bytes(const std::vector<T> &vector) {
+    std::size_t bytes = vector.capacity() * sizeof(T);
+    for (const auto &element : vector)
+        bytes += heap_bytes(element);
+
+    return bytes;
+}
+
+// The payload of an optional is stored inline.
+template <typename T> std::size_t heap_bytes(const boost::optional<T> &value) {
+    return value ? heap_bytes(value.value()) : 0;
+}
+
+inline std::size_t heap_bytes_of() { return 0; }
+
+template <typename T, typename... Rest>
+std::size_t heap_bytes_of(const T &first, const Rest &... rest) {
+    return heap_bytes(first) + heap_bytes_of(rest...);
+}
+}
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <feed/cancellation.h>
+#include <feed/extension.h>
+#include <feed/parse_stats.h>
+#include <string>
+
+namespace feed {
+// What parse_rss() and parse_atom() do with ill-formed UTF-8 in a document.
+enum class utf8_policy : std::uint8_t {
+    pass_through, // Copy the bytes as they are, unchecked.
+    replace,      // Replace ill-formed sequences with U+FFFD.
+    reject        // Fail to parse the document.
+};
+
+// What parse_rss() and parse_atom() do when a document goes past a limit
+// that allows a choice.
+enum class limit_policy : std::uint8_t {
+    fail,    // Fail to parse the document.
+    truncate // Keep what fits and parse on.
+};
+
+// Bounds on what a document may make the parsers allocate, 0 for none. They
+// are checked before the memory is allocated. There is no limit on entity
+// expansion: the DOCTYPE is skipped, so only the predefined entities and
+// character references are decoded, and they never make text longer.
+struct parse_limits {
+    // Checked up front, a document cut short would not be well-formed.
+    std::size_t max_document_bytes = 0;
+    // Nesting of elements, past it the document fails as the reader has to
+    // track each level, even in skipped elements. Extensions are bounded to
+    // 256 levels in any case, deeper children fail or are skipped.
+    std::size_t max_depth = 0;
+    // Items, or entries, past it are skipped under truncate.
+    std::size_t max_items = 0;
+    // Decoded bytes of a single text or attribute value, cut short at a
+    // character boundary under truncate.
+    std::size_t max_field_bytes = 0;
+    limit_policy policy = limit_policy::fail;
+};
+
+// Optional settings for parse_rss() and parse_atom().
+struct parse_options {
+    // Filled in when the library is built with FEED_PARSER_STATS.
+    parse_stats *stats = nullptr;
+    // Foreign elements whose namespace is registered here are kept as
+    // extensions, the rest are skipped.
+    const extension_registry *extensions = nullptr;
+    // The charset declared by the transport, e.g. fetch_result::charset. It
+    // takes precedence over the XML declaration, a byte order mark over both.
+    std::string charset;
+    // Under replace and reject the document is checked once before it is
+    // parsed, and the strings of the result are guaranteed to be valid UTF-8,
+    // see rss_data::valid_utf8().
+    utf8_policy utf8 = utf8_policy::pass_through;
+    // Checked every few hundred tokens, the parse fails once either is
+    // reached.
+    cancellation_token cancel;
+    boost::optional<std::chrono::steady_clock::time_point> deadline;
+    parse_limits limits;
+};
+}
@@ -0,0 +1,55 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace feed {
+// Filled in by parse_rss() and parse_atom() when the library is built with
+// FEED_PARSER_STATS, otherwise the instrumentation is compiled out and the
+// counters stay zero.
+struct parse_stats {
+    std::uint64_t bytes = 0; // Bytes of the document consumed.
+    std::uint64_t items = 0; // Items or entries parsed.
+    std::uint64_t invalid_dates = 0; // Dates left unset as unparsable.
+
+    std::chrono::nanoseconds tokenize{0}; // Scanning the markup.
+    std::chrono::nanoseconds dates{0};    // Parsing dates.
+    std::chrono::nanoseconds decode{0};   // Decoding text and attributes.
+    std::chrono::nanoseconds build{0};    // Building the result.
+
+    std::uint64_t allocations = 0; // Heap allocations made for the result's
+                                   // strings and vectors.
+
+    std::string failed_element; // Path of the element being parsed when the
+                                // parse failed, e.g. "rss/channel/item".
+};
+}
@@ -29,10 +29,16 @@
 #pragma once
 
 #include <chrono>
+#include <feed/extension.h>
+#include <feed/feed_state.h>
 #include <feed/link.h>
+#include <feed/parse_options.h>
+#include <functional>
+#include <vector>
 
 namespace feed {
 namespace rss {
+class parser;
 class rss_data;
 
 class category {
@@ -49,7 +55,13 @@ class category {
     const std::string &value() const { return value_; }
     const boost::optional<std::string> &domain() const { return domain_; }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(value_, domain_);
+    }
+
   private:
+    friend class detail::codec;
+
     std::string value_;
     boost::optional<std::string>
         domain_; // A string that identifies a categorization taxonomy.
@@ -90,8 +102,13 @@ class cloud {
         return *this;
     }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(domain_, path_, register_procedure_);
+    }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     cloud() {}
 
@@ -141,8 +158,13 @@ class image {
         return *this;
     }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(url_, title_, link_, description_);
+    }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     image() {}
 
@@ -181,8 +203,13 @@ class text_input {
         return *this;
     }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(title_, description_, name_, link_);
+    }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     text_input() {}
 
@@ -221,7 +248,13 @@ class image {
         return *this;
     }
 
+    std::size_t memory_usage() const { return detail::heap_bytes_of(href_); }
+
   private:
+    friend class detail::codec;
+
+    image() {}
+
     std::string href_;
 };
 
@@ -248,9 +281,13 @@ class itunes_extensions {
         return *this;
     }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(image_, new_feed_url_);
+    }
+
   private:
-    friend boost::optional<rss::rss_data>
-    rss::parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class rss::parser;
 
     itunes_extensions() {}
 
@@ -276,8 +313,13 @@ class enclosure {
     const boost::optional<std::uint64_t> &length() const { return length_; }
     const std::string &type() const { return type_; }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(url_, type_);
+    }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     std::string url_;                       // Where the enclosure is located.
     boost::optional<std::uint64_t> length_; // How big it is in bytes
@@ -298,8 +340,11 @@ class guid {
     const std::string &value() const { return value_; }
     bool is_perma_link() const { return is_perma_link_; }
 
+    std::size_t memory_usage() const { return detail::heap_bytes_of(value_); }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     std::string value_;
     bool is_perma_link_; // If its value is false, the guid may not be assumed
@@ -318,8 +363,13 @@ class source {
     const std::string &value() const { return value_; }
     const std::string &url() const { return url_; }
 
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(value_, url_);
+    }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     std::string value_;
     std::string url_;
@@ -334,7 +384,8 @@ class item {
           description_(other.description_), author_(other.author_),
           categories_(other.categories_), comments_(other.comments_),
           enclosure_(other.enclosure_), guid_(other.guid_),
-          pub_date_(other.pub_date_), source_(other.source_) {}
+          pub_date_(other.pub_date_), source_(other.source_),
+          extensions_(other.extensions_) {}
     item(item &&other) noexcept : title_(std::move(other.title_)),
                                   link_(std::move(other.link_)),
                                   description_(std::move(other.description_)),
@@ -344,7 +395,8 @@ class item {
                                   enclosure_(std::move(other.enclosure_)),
                                   guid_(std::move(other.guid_)),
                                   pub_date_(other.pub_date_),
-                                  source_(std::move(other.source_)) {}
+                                  source_(std::move(other.source_)),
+                                  extensions_(std::move(other.extensions_)) {}
 
     const boost::optional<std::string> &title() const { return title_; }
     const boost::optional<std::string> &link() const { return link_; }
@@ -366,9 +418,21 @@ class item {
         return pub_date_;
     }
     const boost::optional<class source> &source() const { return source_; }
+    // Elements from the namespaces registered in parse_options::extensions.
+    const boost::optional<std::vector<extension>> &extensions() const {
+        return extensions_;
+    }
+
+    // Heap bytes retained by the item, see detail::heap_bytes().
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(
+            title_, link_, description_, author_, categories_, comments_,
+            enclosure_, guid_, source_, extensions_);
+    }
 
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     item() {}
 
@@ -391,6 +455,7 @@ class item {
         pub_date_;
     boost::optional<class source>
         source_; // The RSS channel that the item came from.
+    boost::optional<std::vector<extension>> extensions_;
 };
 
 class rss_data {
@@ -408,7 +473,8 @@ class rss_data {
           image_(other.image_), text_input_(other.text_input_),
           skip_hours_(other.skip_hours_), skip_days_(other.skip_days_),
           items_(other.items_), atom_link_(other.atom_link_),
-          itunes_(other.itunes_) {}
+          itunes_(other.itunes_), extensions_(other.extensions_),
+          valid_utf8_(other.valid_utf8_) {}
     rss_data(rss_data &&other) noexcept
         : title_(std::move(other.title_)),
           link_(std::move(other.link_)),
@@ -430,7 +496,9 @@ class rss_data {
           skip_days_(std::move(other.skip_days_)),
           items_(std::move(other.items_)),
           atom_link_(std::move(other.atom_link_)),
-          itunes_(std::move(other.itunes_)) {}
+          itunes_(std::move(other.itunes_)),
+          extensions_(std::move(other.extensions_)),
+          valid_utf8_(other.valid_utf8_) {}
 
     const std::string &title() const { return title_; }
     const std::string &link() const { return link_; }
@@ -478,6 +546,13 @@ class rss_data {
     itunes() const {
         return itunes_;
     }
+    // Elements from the namespaces registered in parse_options::extensions.
+    const boost::optional<std::vector<extension>> &extensions() const {
+        return extensions_;
+    }
+    // Whether every string of the feed is known to be valid UTF-8, see
+    // parse_options::utf8.
+    bool valid_utf8() const { return valid_utf8_; }
 
     rss_data &operator=(rss_data &&other) noexcept {
         if (&other != this) {
@@ -502,13 +577,25 @@ class rss_data {
             items_ = std::move(other.items_);
             atom_link_ = std::move(other.atom_link_);
             itunes_ = std::move(other.itunes_);
+            extensions_ = std::move(other.extensions_);
+            valid_utf8_ = other.valid_utf8_;
         }
 
         return *this;
     }
 
+    // Heap bytes retained by the feed, sizeof(rss_data) not included.
+    std::size_t memory_usage() const {
+        return detail::heap_bytes_of(
+            title_, link_, description_, language_, copyright_,
+            managing_editor_, web_master_, categories_, generator_, docs_,
+            cloud_, image_, text_input_, skip_hours_, skip_days_, items_,
+            atom_link_, itunes_, extensions_);
+    }
+
   private:
-    friend boost::optional<rss_data> parse_rss(const std::string &xml_str);
+    friend class detail::codec;
+    friend class parser;
 
     std::string title_; // The name of the channel.
     std::string
@@ -564,8 +651,44 @@ class rss_data {
     // resource (such as a page) and an
     // RSS channel or item.
     boost::optional<class itunes::channel_level::itunes_extensions> itunes_;
+    boost::optional<std::vector<extension>> extensions_;
+    bool valid_utf8_ = false;
 };
 
 boost::optional<rss_data> parse_rss(const std::string &xml_str);
+boost::optional<rss_data> parse_rss(const std::string &xml_str,
+                                    parse_stats &stats);
+boost::optional<rss_data> parse_rss(const std::string &xml_str,
+                                    const parse_options &options);
+// The result of parse_rss() against the state of a previous poll.
+struct rss_delta {
+    explicit rss_delta(rss_data &&feed) : data(std::move(feed)) {}
+
+    // The channel, with only the items new or changed since that poll.
+    rss_data data;
+    // Indices in data.items() of the items seen before with other content,
+    // the others are new.
+    std::vector<std::size_t> changed;
+    std::size_t unchanged = 0; // Items skipped as seen before.
+    feed_state state;          // Of this document, for the next poll.
+};
+
+// Items of previous whose bytes are the same are skipped without being
+// built, only hashed. The other items are parsed as usual.
+boost::optional<rss_delta> parse_rss(const std::string &xml_str,
+                                     const feed_state &previous,
+                                     const parse_options &options =
+                                         parse_options());
+// Hands each item to on_item as soon as it is built instead of keeping it,
+// so that memory does not grow with the feed. on_item returns false to stop
+// the parse there. on_channel then receives the channel, without items, last:
+// channel elements may follow the items, it gets them all unless the parse
+// has been stopped. Returns false if the document failed to parse, after some
+// of its items may have been handed over. What on_item throws ends the parse
+// and is rethrown, on_channel is not called then.
+bool parse_rss(const std::string &xml_str,
+               const std::function<void(rss_data &&)> &on_channel,
+               const std::function<bool(item &&)> &on_item,
+               const parse_options &options = parse_options());
 }
 }
@@ -0,0 +1,136 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cstdint>
+#include <feed/fetcher.h>
+#include <feed/rss_parser.h>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace feed {
+// What a feed says about how often it should be polled.
+struct poll_hints {
+    boost::optional<std::chrono::minutes> ttl;
+    // From an interval_estimator, preferred over the ttl when set.
+    boost::optional<std::chrono::seconds> estimate;
+    std::vector<std::uint16_t> skip_hours; // Hours of the day, in GMT.
+    std::vector<rss::day> skip_days;       // Days of the week, in GMT.
+
+    static poll_hints from(const rss::rss_data &feed);
+};
+
+struct scheduler_config {
+    std::chrono::seconds min_interval{15 * 60};
+    std::chrono::seconds max_interval{24 * 60 * 60};
+    // For feeds without a ttl.
+    std::chrono::seconds default_interval{60 * 60};
+    // Each interval is moved by up to this fraction of itself, either way, so
+    // that feeds added together do not stay in lockstep.
+    double jitter = 0.1;
+    std::uint64_t seed = 0;
+};
+
+// Keeps the next due time of each feed in a binary heap, by URL. Feeds are
+// taken out of the heap when they are handed out by due() or dispatch(), and
+// go back in when polled() reports how the poll went. Safe to share between
+// threads.
+class scheduler {
+  public:
+    using clock = std::chrono::system_clock;
+
+    explicit scheduler(scheduler_config config = scheduler_config());
+
+    // Schedules uri, or reschedules it if it is known.
+    void add(const std::string &uri, clock::time_point due = clock::now());
+    bool remove(const std::string &uri);
+
+    // Schedules the next poll of uri, polled at at, from hints: after the
+    // estimate, the ttl or the default interval, jittered and clamped to the
+    // configured bounds, then moved past the skipped hours and days. Returns
+    // when.
+    clock::time_point polled(const std::string &uri, const poll_hints &hints,
+                             clock::time_point at = clock::now());
+
+    // Takes out up to max feeds due at now, the most overdue first.
+    std::vector<std::string>
+    due(clock::time_point now = clock::now(),
+        std::size_t max = std::numeric_limits<std::size_t>::max());
+
+    // Starts a fetch_async() for each feed due at now, handler is called
+    // with the result on a pplx thread and should end with polled(). What it
+    // or the fetch throws is logged. Returns the number of fetches started.
+    std::size_t
+    dispatch(fetcher &fetcher,
+             std::function<void(const std::string &uri,
+                                const fetch_result &result)> handler,
+             clock::time_point now = clock::now());
+
+    // The earliest due time, none if nothing is scheduled.
+    boost::optional<clock::time_point> next_due() const;
+    // Feeds known, scheduled or handed out.
+    std::size_t size() const;
+
+  private:
+    struct entry {
+        std::string uri;
+        std::uint32_t generation = 0; // Invalidates older heap slots.
+        bool scheduled = false;
+    };
+    struct slot {
+        clock::time_point due;
+        std::uint32_t id;
+        std::uint32_t generation;
+
+        bool operator>(const slot &other) const { return due > other.due; }
+    };
+
+    void schedule(std::uint32_t id, clock::time_point due);
+    // Whether slot no longer matches its entry.
+    bool stale(const slot &slot) const;
+    // Pops the stale slots off the top of the heap, so that it is live.
+    void drop_stale();
+    clock::duration interval(const poll_hints &hints);
+
+    const scheduler_config config_;
+    mutable std::mutex mutex_;
+    std::mt19937_64 random_;
+    std::unordered_map<std::string, std::uint32_t> ids_;
+    std::vector<entry> entries_;
+    std::vector<std::uint32_t> free_;
+    std::vector<slot> heap_; // A min-heap on due.
+};
+}
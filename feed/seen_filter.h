@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <feed/hash.h>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+
+namespace feed {
+// A Bloom filter of the identities of the items seen so far, around 2 bytes
+// per item for one false positive in a thousand. Lookups and inserts
+// are lock-free and may run concurrently from any number of threads, a
+// lookup that races an insert of the same identity may miss it.
+//
+// The bits of an identity all fall in one 64-byte block, a single cache
+// miss per lookup, for slightly more false positives than a classic filter
+// of the same size.
+class seen_filter {
+  public:
+    // Asked to confirm a hit, e.g. against a database, as false positives
+    // are possible but false negatives are not.
+    using confirm = std::function<bool(boost::string_ref identity)>;
+
+    // Sized for capacity identities at false_positive_rate, the rate grows
+    // past it.
+    explicit seen_filter(std::uint64_t capacity,
+                         double false_positive_rate = 0.001);
+    seen_filter(seen_filter &&other) noexcept;
+    seen_filter(const seen_filter &) = delete;
+
+    seen_filter &operator=(seen_filter &&other) noexcept;
+    seen_filter &operator=(const seen_filter &) = delete;
+
+    // Whether identity has probably been inserted. Always false for an
+    // empty identity.
+    bool contains(boost::string_ref identity) const;
+    // As contains(), a hit is then only reported if exact confirms it.
+    bool contains(boost::string_ref identity, const confirm &exact) const;
+    bool contains(const rss::item &item) const {
+        return contains(identity(item));
+    }
+    bool contains(const atom::entry &entry) const {
+        return contains(identity(entry));
+    }
+
+    // Returns whether identity had probably been inserted before.
+    bool insert(boost::string_ref identity);
+    bool insert(const rss::item &item) { return insert(identity(item)); }
+    bool insert(const atom::entry &entry) { return insert(identity(entry)); }
+
+    // Identities inserted, not counting those that looked present already.
+    std::uint64_t size() const { return size_.load(std::memory_order_relaxed); }
+    std::size_t memory_usage() const { return blocks_ * block_bytes; }
+
+    // A versioned image, its words in the byte order of this machine, which
+    // the header records. Concurrent inserts may or may not be in it.
+    void save(std::ostream &out) const;
+    // Reads images of either byte order. Fails, logging the reason, on an
+    // image that is truncated or not one.
+    static boost::optional<seen_filter> load(std::istream &in);
+
+  private:
+    static const std::size_t block_bytes = 64;
+    static const std::size_t block_words = block_bytes / 8;
+
+    struct layout {
+        std::uint64_t blocks;
+        std::uint32_t hashes; // Bits per identity.
+    };
+
+    explicit seen_filter(layout sized);
+
+    static layout size_for(std::uint64_t capacity, double false_positive_rate);
+
+    // Calls found(word, mask) for each bit of hash, stops when it returns
+    // false.
+    template <typename Function>
+    bool each_bit(std::uint64_t hash, Function found) const;
+
+    std::uint64_t blocks_;
+    std::uint32_t hashes_; // Bits per identity.
+    std::unique_ptr<std::atomic<std::uint64_t>[]> words_;
+    std::atomic<std::uint64_t> size_;
+};
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <feed/atom_parser.h>
+#include <feed/rss_parser.h>
+#include <string>
+
+namespace feed {
+// A compact, versioned binary image of a parsed feed, to hand feeds between
+// processes or keep them between polls, and read them back for a fraction of
+// the cost of parsing. Strings and vectors are prefixed with their length,
+// each object with a bitmask of its optional members present, integers are
+// variable-length and little-endian.
+std::string serialize(const rss::rss_data &feed);
+std::string serialize(const atom::atom_data &feed);
+
+// Fail, logging the reason, on data that is truncated or not the image of a
+// feed of that kind in this version.
+boost::optional<rss::rss_data> deserialize_rss(boost::string_ref data);
+boost::optional<atom::atom_data> deserialize_atom(boost::string_ref data);
+}
@@ -0,0 +1,187 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <feed/atom_parser.h>
+#include <feed/rss_parser.h>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace feed {
+enum class feed_format : std::uint8_t { rss, atom };
+
+// An item of a snapshot, its fields read in place from the snapshot, which
+// must outlive it. Missing fields are empty, and so are those whose bytes
+// are out of bounds in a corrupt snapshot.
+class snapshot_item {
+  public:
+    // The guid, the link if it has none, or the id of an Atom entry.
+    boost::string_ref id() const { return string(1); }
+    boost::string_ref title() const { return string(3); }
+    // For an Atom entry its alternate link, its first link if it has none.
+    boost::string_ref link() const { return string(5); }
+    // The description, or the summary of an Atom entry.
+    boost::string_ref summary() const { return string(7); }
+    boost::optional<std::chrono::time_point<std::chrono::system_clock,
+                                            std::chrono::seconds>>
+    pub_date() const;
+
+  private:
+    friend class snapshot_feed;
+
+    snapshot_item(const char *record, const char *strings,
+                  std::uint64_t strings_size)
+        : record_(record), strings_(strings), strings_size_(strings_size) {}
+
+    boost::string_ref string(std::size_t word) const;
+
+    const char *record_;
+    const char *strings_;
+    std::uint64_t strings_size_;
+};
+
+// A feed of a snapshot, see snapshot_item.
+class snapshot_feed {
+  public:
+    feed_format format() const;
+    boost::string_ref uri() const { return string(1); }
+    boost::string_ref title() const { return string(3); }
+    // For an Atom feed its alternate link, its first link if it has none.
+    boost::string_ref link() const { return string(5); }
+    // The description, or the subtitle of an Atom feed.
+    boost::string_ref description() const { return string(7); }
+    // The lastBuildDate, the pubDate if it has none.
+    boost::optional<std::chrono::time_point<std::chrono::system_clock,
+                                            std::chrono::seconds>>
+    updated() const;
+
+    // Number of items.
+    std::size_t size() const;
+    // index must be less than size().
+    snapshot_item item(std::size_t index) const;
+
+    // The whole feed, deserialized from the image stored with it. None if
+    // it is of the other format or the snapshot was written without models.
+    boost::optional<rss::rss_data> load_rss() const;
+    boost::optional<atom::atom_data> load_atom() const;
+
+  private:
+    friend class snapshot;
+
+    snapshot_feed(const char *record, const char *items, const char *strings,
+                  std::uint64_t strings_size)
+        : record_(record), items_(items), strings_(strings),
+          strings_size_(strings_size) {}
+
+    boost::string_ref string(std::size_t word) const;
+
+    const char *record_;
+    const char *items_;
+    const char *strings_;
+    std::uint64_t strings_size_;
+};
+
+// Many parsed feeds in one read-only file, laid out to be mapped into memory
+// and read in place: fixed-size records of feeds and items referring to a
+// pool of strings, and an index of the feeds sorted by the hash64() of their
+// URL. Opening one reads its header only, the pages of a feed are touched
+// when it is looked up, which checks that its record and the range of its
+// items are in bounds, and those of an item when it is read. Safe to share
+// between threads.
+class snapshot {
+  public:
+    // Maps the file at path. Fails, logging the reason, if it cannot or the
+    // file is not a snapshot.
+    static boost::optional<snapshot> open(const std::string &path);
+    // Over image, which must outlive the snapshot.
+    static boost::optional<snapshot> from(boost::string_ref image);
+
+    // Number of feeds.
+    std::size_t size() const { return feeds_; }
+    // None if uri is not in the snapshot or its records are corrupt.
+    boost::optional<snapshot_feed> find(boost::string_ref uri) const;
+    // The index-th feed in the order of the index.
+    boost::optional<snapshot_feed> at(std::size_t index) const;
+
+  private:
+    snapshot() {}
+
+    // The feed whose record is the index-th, if it and the range of its
+    // items are in bounds.
+    boost::optional<snapshot_feed> checked(std::uint64_t index) const;
+    // Whether the string at record + word * 8 is in the pool.
+    bool in_pool(const char *record, std::size_t word) const;
+
+    std::shared_ptr<const void> mapping_; // Keeps the file mapped.
+    const char *index_ = nullptr;
+    const char *feed_records_ = nullptr;
+    const char *item_records_ = nullptr;
+    const char *strings_ = nullptr;
+    std::size_t feeds_ = 0;
+    std::uint64_t items_ = 0;
+    std::uint64_t strings_size_ = 0;
+};
+
+// Builds a snapshot in memory, to be saved to a file.
+class snapshot_writer {
+  public:
+    // With models, each feed is also stored as its serialize() image, for
+    // snapshot_feed::load_rss() and load_atom().
+    explicit snapshot_writer(bool models = true) : models_(models) {}
+
+    // A URL added again replaces its feed, the bytes of the previous one
+    // stay in the file.
+    void add(const std::string &uri, const rss::rss_data &feed);
+    void add(const std::string &uri, const atom::atom_data &feed);
+
+    std::size_t size() const { return uris_.size(); }
+
+    void save(std::ostream &out) const;
+
+  private:
+    // Appends value to the pool and its place to record.
+    void add_string(std::string &record, boost::string_ref value);
+    void add_feed(const std::string &uri, std::string record);
+
+    bool models_;
+    std::string feed_records_;
+    std::string item_records_;
+    std::string strings_;
+    std::uint64_t items_ = 0;
+    std::unordered_map<std::string, std::size_t> uris_; // To feed records.
+};
+}
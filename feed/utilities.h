@@ -30,47 +30,52 @@
 
 #include <boost/optional.hpp>
 #include <cpprest/http_client.h>
+#include <feed/fetcher.h>
+#include <feed/log.h>
+#include <memory>
 
 using namespace utility;
 
 namespace feed {
 namespace utility {
+// Kept for compatibility, downloads through a feed::fetcher of its own. Share
+// a feed::fetcher instead to reuse connections across instances and threads.
 class xml {
   public:
-    boost::optional<std::string> to_string(const std::string uri) const {
-        try {
-            web::http::client::http_client client(conversions::to_string_t(uri),
-                                                  http_client_config_);
-            const auto response = client.request(web::http::methods::GET);
+    xml() : fetcher_(std::make_shared<feed::fetcher>()) {}
 
-            return conversions::to_utf8string(
-                response.get().extract_string(true).get()); // FIXME
-        } catch (const web::uri_exception &e) {
-            std::cerr << "Error: " << e.what() << std::endl;
-        } catch (const std::invalid_argument &e) {
-            std::cerr << "Error: " << e.what() << std::endl;
-        } catch (const web::http::http_exception &e) {
-            std::cerr << "Error: " << e.what() << std::endl;
-        }
+    // None on any status but 200, where the body of the response used to be
+    // returned whatever its status.
+    boost::optional<std::string> to_string(const std::string uri) const {
+        auto result = fetcher_->fetch(uri);
+        if (!result)
+            return {};
 
-        return {};
+        return std::move(result.body);
     }
+    // Both replace the fetcher, closing the connections it pooled.
     bool set_proxy(const std::string &uri) {
         try {
-            http_client_config_.set_proxy(
-                web::web_proxy(conversions::to_string_t(uri)));
-
-            return true;
+            const web::uri proxy(conversions::to_string_t(uri));
         } catch (const web::uri_exception &e) {
-            std::cerr << "Error: " << e.what() << std::endl;
+            feed::log(feed::log_level::error, e.what());
+
+            return false;
         }
 
-        return false;
+        config_.proxy = uri;
+        fetcher_ = std::make_shared<feed::fetcher>(config_);
+
+        return true;
+    }
+    void clear_proxy() {
+        config_.proxy = boost::none;
+        fetcher_ = std::make_shared<feed::fetcher>(config_);
     }
-    void clear_proxy() { http_client_config_.set_proxy(web::web_proxy()); }
 
   protected:
-    web::http::client::http_client_config http_client_config_;
+    fetcher_config config_;
+    std::shared_ptr<feed::fetcher> fetcher_;
 };
 }
 }
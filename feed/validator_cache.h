@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace feed {
+// The ETag and Last-Modified headers of the last successful fetch of a feed.
+struct validators {
+    boost::optional<std::string> etag;
+    boost::optional<std::string> last_modified;
+    // normalized_fingerprint() of the body, see fetcher_config::fingerprints.
+    boost::optional<std::uint64_t> fingerprint;
+};
+
+// Validators by URL, so that a fetcher can send conditional requests and tell
+// unchanged feeds apart. Safe to share between threads and fetchers.
+class validator_cache {
+  public:
+    boost::optional<validators> find(const std::string &uri) const;
+    // Forgets uri when none of entry is set.
+    void store(const std::string &uri, validators entry);
+    void erase(const std::string &uri);
+    void clear();
+    std::size_t size() const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, validators> entries_;
+};
+}
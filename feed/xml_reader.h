@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace feed {
+class xml_error : public std::runtime_error {
+  public:
+    xml_error(const std::string &what, std::size_t offset)
+        : std::runtime_error(what + " at offset " + std::to_string(offset)),
+          offset_(offset) {}
+
+    std::size_t offset() const { return offset_; }
+
+  private:
+    std::size_t offset_;
+};
+
+// A forward-only pull tokenizer over an XML document held in memory. Names,
+// attribute values and text are returned as views into the document, nothing
+// is copied or decoded until the caller asks for it with decode_xml().
+//
+// Like the RapidXML parser behind boost::property_tree it is lenient: the
+// declaration, processing instructions, comments and the DOCTYPE are skipped,
+// and end tags are not matched against the open element by name. Namespace
+// declarations are tracked so that prefixes can be resolved to their URIs.
+class xml_reader {
+  public:
+    enum class token : std::uint8_t {
+        start_element,
+        end_element,
+        text,
+        end_document
+    };
+
+    struct attribute {
+        boost::string_ref name;
+        boost::string_ref value; // Not decoded.
+    };
+
+    xml_reader(const char *begin, const char *end) noexcept
+        : begin_(begin),
+          end_(end),
+          pos_(begin),
+          element_(begin) {}
+
+    token next();
+
+    // Makes next() fail on a start element nested deeper than depth, 0 for
+    // no limit.
+    void set_max_depth(std::size_t depth) { max_depth_ = depth; }
+
+    // Consumes everything up to and including the end tag of the element that
+    // was just started.
+    void skip();
+    // Like skip(), given the offset just past that end tag, e.g. as found
+    // by another reader, without reading what lies in between.
+    void skip_to(std::size_t offset);
+
+    // The qualified name of the current start or end element.
+    boost::string_ref name() const { return name_; }
+    boost::string_ref prefix() const;
+    boost::string_ref local_name() const;
+    // The namespace of the current start element, empty if it has none.
+    boost::string_ref namespace_uri() const { return resolve(prefix()); }
+    // The URI prefix is bound to, empty for an unbound prefix.
+    boost::string_ref resolve(boost::string_ref prefix) const;
+    // Whether an open element binds a prefix or the default namespace to uri.
+    bool bound(boost::string_ref uri) const;
+    // The attributes of the current start element.
+    const std::vector<attribute> &attributes() const { return attributes_; }
+    boost::optional<boost::string_ref>
+    attribute_value(boost::string_ref name) const;
+
+    // The current character data or CDATA section, not decoded.
+    boost::string_ref text() const { return text_; }
+    bool cdata() const { return cdata_; }
+
+    // Number of open elements, the current start element included.
+    std::size_t depth() const { return open_.size(); }
+    std::size_t offset() const {
+        return static_cast<std::size_t>(pos_ - begin_);
+    }
+    // Offset of the '<' of the current start element.
+    std::size_t element_offset() const {
+        return static_cast<std::size_t>(element_ - begin_);
+    }
+    // Slash separated names of the open elements, e.g. "rss/channel/item".
+    std::string path() const;
+
+  private:
+    struct binding {
+        boost::string_ref prefix; // Empty for the default namespace.
+        boost::string_ref uri;
+        std::size_t depth; // Depth of the declaring element.
+    };
+
+    void close();
+    void skip_until(const char *terminator);
+    void skip_doctype();
+    boost::string_ref scan_name();
+    void skip_whitespace();
+    [[noreturn]] void fail(const char *what) const;
+
+    const char *begin_;
+    const char *end_;
+    const char *pos_;
+    const char *element_;
+
+    boost::string_ref name_;
+    std::vector<attribute> attributes_;
+    boost::string_ref text_;
+    bool cdata_ = false;
+    bool pending_end_ = false; // The current start element was <name/>.
+    std::vector<boost::string_ref> open_;
+    std::vector<binding> bindings_;
+    std::size_t max_depth_ = 0;
+};
+
+// Appends raw to out with the predefined entities and the character references
+// replaced. Unknown entities are kept verbatim.
+void decode_xml(boost::string_ref raw, std::string &out);
+}
@@ -26,329 +26,393 @@
 **
 ****************************************************************************/
 
-#include <iostream>
-#include <boost/property_tree/xml_parser.hpp>
+#include "parse_context.h"
+#include <exception>
 #include <feed/atom_parser.h>
-
-class atom_exception : public std::exception {
-  public:
-    const char *what() const noexcept override { return ""; }
-};
+#include <feed/log.h>
+#include <stdexcept>
 
 namespace feed {
 namespace atom {
-boost::optional<atom_data> parse_atom(const std::string &xml_str) {
-    boost::property_tree::ptree root;
-
-    std::istringstream stream(xml_str);
-
-    atom_data data;
-
-    try {
-        boost::property_tree::read_xml(stream, root);
-
-        const auto &feed_node = root.get_child("feed");
-
-        data.id_ = feed_node.get<std::string>("id");
-
-        const auto &title_node = feed_node.get_child("title");
-        data.title_.value_ = title_node.get_value<std::string>();
-        const auto title_type_node =
-            title_node.get_child_optional("<xmlattr>.type");
-        if (title_type_node) {
-            std::string type = title_type_node->get_value<std::string>();
-            if (type == "html")
-                data.title_.type_ = text::type::html;
-            else if (type == "xhtml")
-                data.title_.type_ = text::type::xhtml;
+class parser {
+  public:
+    parser(const std::string &xml_str, const parse_options &options,
+           const std::function<bool(entry &&)> *on_entry = nullptr,
+           detail::delta_tracker *delta = nullptr)
+        : context_(xml_str, options), on_entry_(on_entry), delta_(delta) {}
+
+    boost::optional<atom_data> parse() {
+        try {
+            atom_data data = document();
+            context_.finish(false);
+
+            return std::move(data);
+        } catch (const std::exception &e) {
+            context_.finish(true);
+            if (callback_error_)
+                std::rethrow_exception(callback_error_);
+            if (log_enabled(log_level::error))
+                log(log_level::error, std::string("parse_atom: ") + e.what());
         }
 
-        const auto generator_node = feed_node.get_child_optional("generator");
-        if (generator_node)
-            data.generator_.emplace(
-                generator_node->get_value<std::string>(),
-                generator_node->get_optional<std::string>("<xmlattr>.uri"),
-                generator_node->get_optional<std::string>("<xmlattr>.version"));
-
-        data.icon_ = feed_node.get_optional<std::string>("icon");
-        data.logo_ = feed_node.get_optional<std::string>("logo");
-
-        const auto rights_node = feed_node.get_child_optional("rights");
-        if (rights_node) {
-            enum text::type type = text::type::text;
-            const auto rights_type_node =
-                rights_node->get_child_optional("<xmlattr>.type");
-            if (rights_type_node) {
-                std::string type_str =
-                    rights_type_node->get_value<std::string>();
-                if (type_str == "html")
-                    type = text::type::html;
-                else if (type_str == "xhtml")
-                    type = text::type::xhtml;
-            }
+        return {};
+    }
 
-            data.rights_.emplace(rights_node->get_value<std::string>(), type);
+  private:
+    atom_data document() {
+        atom_data data;
+        bool has_feed = false;
+        context_.begin();
+        data.valid_utf8_ = context_.valid_utf8();
+
+        for (;;) {
+            const auto token = context_.next();
+            if (token == xml_reader::token::end_document)
+                break;
+            if (token != xml_reader::token::start_element)
+                continue;
+
+            if (!has_feed && atom_name() == "feed") {
+                feed(data);
+                has_feed = true;
+                if (stopped_)
+                    break;
+            } else {
+                if (!has_feed && context_.reader().local_name() == "feed" &&
+                    log_enabled(log_level::warning))
+                    log(log_level::warning,
+                        "parse_atom: feed in namespace " +
+                            context_.reader().namespace_uri().to_string() +
+                            " is not Atom");
+                context_.skip();
+            }
         }
 
-        const auto subtitle_node = feed_node.get_child_optional("subtitle");
-        if (subtitle_node) {
-            std::string subtitle = subtitle_node->get_value<std::string>();
-            enum text::type type = text::type::text;
-            const auto subtitle_type_node =
-                subtitle_node->get_child_optional("<xmlattr>.type");
-            if (subtitle_type_node) {
-                std::string type_str =
-                    subtitle_type_node->get_value<std::string>();
-                if (type_str == "html")
-                    type = text::type::html;
-                else if (type_str == "xhtml")
-                    type = text::type::xhtml;
-            }
+        if (!has_feed)
+            detail::parse_context::missing("feed");
 
-            data.subtitle_.emplace(std::move(subtitle), type);
-        }
+        return data;
+    }
 
+    void feed(atom_data &data) {
+        bool has_id = false;
+        bool has_title = false;
         std::vector<person> authors;
         std::vector<link> links;
         std::vector<category> categories;
         std::vector<person> contributors;
+        std::vector<extension> extensions;
 
-        for (const auto &feed_child : feed_node)
-            if (feed_child.first == "author") {
-                const auto &author_node = feed_child.second;
-
-                authors.emplace_back(
-                    author_node.get<std::string>("name"),
-                    author_node.get_optional<std::string>("email"),
-                    author_node.get_optional<std::string>("uri"));
-            } else if (feed_child.first == "link") {
-                const auto &link_attr_node =
-                    feed_child.second.get_child("<xmlattr>");
-
-                link link;
-                link.href_ = link_attr_node.get<std::string>("href");
-                link.href_lang_ =
-                    link_attr_node.get_optional<std::string>("hreflang");
-                link.length_ =
-                    link_attr_node.get_optional<std::uint64_t>("length");
-                link.title_ = link_attr_node.get_optional<std::string>("title");
-                link.type_ = link_attr_node.get_optional<std::string>("type");
-
-                const auto rel_node = link_attr_node.get_child_optional("rel");
-                if (rel_node) {
-                    const std::string ref = rel_node->get_value<std::string>();
-                    if (ref == "alternate")
-                        link.rel_ = rel::alternate;
-                    else if (ref == "enclosure")
-                        link.rel_ = rel::enclosure;
-                    else if (ref == "related")
-                        link.rel_ = rel::related;
-                    else if (ref == "self")
-                        link.rel_ = rel::self;
-                    else
-                        link.rel_ = rel::via;
-                }
+        while (context_.child()) {
+            const auto name = atom_name();
 
-                links.emplace_back(std::move(link));
-            } else if (feed_child.first == "category") {
-                const auto &category_attr_node =
-                    feed_child.second.get_child("<xmlattr>");
-
-                categories.emplace_back(
-                    category_attr_node.get<std::string>("term"),
-                    category_attr_node.get_optional<std::string>("scheme"),
-                    category_attr_node.get_optional<std::string>("label"));
-            } else if (feed_child.first == "contributor") {
-                const auto &contributor_node = feed_child.second;
-
-                contributors.emplace_back(
-                    contributor_node.get<std::string>("name"),
-                    contributor_node.get_optional<std::string>("email"),
-                    contributor_node.get_optional<std::string>("uri"));
-            } else if (feed_child.first == "entry") {
-                const auto &entry_node = feed_child.second;
-
-                entry entry;
-                entry.id_ = entry_node.get<std::string>("id");
-
-                const auto &title_node = entry_node.get_child("title");
-                entry.title_.value_ = title_node.get_value<std::string>();
-                const auto title_type_node =
-                    title_node.get_child_optional("<xmlattr>.type");
-                if (title_type_node) {
-                    std::string type =
-                        title_type_node->get_value<std::string>();
-                    if (type == "html")
-                        entry.title_.type_ = text::type::html;
-                    else if (type == "xhtml")
-                        entry.title_.type_ = text::type::xhtml;
+            if (name == "entry") {
+                // Before the item is recorded, one over the limit must not
+                // look known to the next poll.
+                if (!context_.more_items(entries_)) {
+                    context_.skip();
+                    continue;
                 }
-
-                const auto content_node =
-                    entry_node.get_child_optional("content");
-                if (content_node) {
-                    std::string content =
-                        content_node->get_value<std::string>();
-                    const auto content_type_node =
-                        content_node->get_child_optional("<xmlattr>.type");
-                    if (content_type_node) {
-                        std::string type =
-                            content_type_node->get_value<std::string>();
-                        if (type == "html")
-                            entry.content_.emplace(std::move(content),
-                                                   text::type::html);
-                        else if (type == "xhtml")
-                            entry.content_.emplace(std::move(content),
-                                                   text::type::xhtml);
-                        else
-                            entry.content_.emplace(std::move(content));
-                    } else {
-                        entry.content_.emplace(std::move(content));
+                if (delta_) {
+                    const auto hashes = context_.hashes({"id"});
+                    if (delta_->unchanged(hashes)) {
+                        context_.skip_to(hashes.end);
+                        continue;
                     }
+                    delta_->built(entries_);
                 }
 
-                const auto summary_node =
-                    entry_node.get_child_optional("summary");
-                if (summary_node) {
-                    std::string summary =
-                        summary_node->get_value<std::string>();
-                    const auto summary_type_node =
-                        summary_node->get_child_optional("<xmlattr>.type");
-                    if (summary_type_node) {
-                        std::string type =
-                            summary_type_node->get_value<std::string>();
-                        if (type == "html")
-                            entry.summary_.emplace(std::move(summary),
-                                                   text::type::html);
-                        else if (type == "xhtml")
-                            entry.summary_.emplace(std::move(summary),
-                                                   text::type::xhtml);
-                        else
-                            entry.summary_.emplace(std::move(summary));
-                    } else {
-                        entry.summary_.emplace(std::move(summary));
-                    }
+                if (!on_entry_) {
+                    context_.append(data.entries_, parse_entry());
+                } else if (!hand_over(parse_entry())) {
+                    stopped_ = true;
+                    break;
                 }
+                context_.item();
+                ++entries_;
+            } else if (name == "author") {
+                context_.append(authors, parse_person());
+            } else if (name == "link") {
+                context_.append(links, parse_link());
+            } else if (name == "category") {
+                context_.append(categories, parse_category());
+            } else if (name == "contributor") {
+                context_.append(contributors, parse_person());
+            } else if (name == "id" && !has_id) {
+                data.id_ = context_.text();
+                has_id = true;
+            } else if (name == "title" && !has_title) {
+                data.title_.type_ = text_type();
+                data.title_.value_ = context_.text();
+                has_title = true;
+            } else if (name == "generator" && !data.generator_) {
+                auto uri = context_.attribute("uri");
+                auto version = context_.attribute("version");
+                data.generator_.emplace(context_.text(), std::move(uri),
+                                        std::move(version));
+            } else if (name == "icon" && !data.icon_) {
+                data.icon_ = context_.text();
+            } else if (name == "logo" && !data.logo_) {
+                data.logo_ = context_.text();
+            } else if (name == "rights" && !data.rights_) {
+                const auto type = text_type();
+                data.rights_.emplace(context_.text(), type);
+            } else if (name == "subtitle" && !data.subtitle_) {
+                const auto type = text_type();
+                data.subtitle_.emplace(context_.text(), type);
+            } else if (!context_.extension(extensions)) {
+                context_.skip();
+            }
+        }
 
-                const auto rights_node =
-                    entry_node.get_child_optional("rights");
-                if (rights_node) {
-                    enum text::type type = text::type::text;
-                    const auto rights_type_node =
-                        rights_node->get_child_optional("<xmlattr>.type");
-                    if (rights_type_node) {
-                        std::string type_str =
-                            rights_type_node->get_value<std::string>();
-                        if (type_str == "html")
-                            type = text::type::html;
-                        else if (type_str == "xhtml")
-                            type = text::type::xhtml;
-                    }
-
-                    entry.rights_.emplace(rights_node->get_value<std::string>(),
-                                          type);
-                }
+        // A stopped parse has not seen the rest of the feed.
+        if (!has_id && !stopped_)
+            detail::parse_context::missing("id");
+        if (!has_title && !stopped_)
+            detail::parse_context::missing("title");
 
-                std::vector<person> authors;
-                std::vector<link> links;
-                std::vector<category> categories;
-                std::vector<person> contributors;
-
-                for (const auto &entry_child : entry_node)
-                    if (entry_child.first == "author") {
-                        const auto &author_node = entry_child.second;
-
-                        authors.emplace_back(
-                            author_node.get<std::string>("name"),
-                            author_node.get_optional<std::string>("email"),
-                            author_node.get_optional<std::string>("uri"));
-                    } else if (entry_child.first == "link") {
-                        const auto &link_attr_node =
-                            entry_child.second.get_child("<xmlattr>");
-
-                        link link;
-                        link.href_ = link_attr_node.get<std::string>("href");
-                        link.href_lang_ =
-                            link_attr_node.get_optional<std::string>(
-                                "hreflang");
-                        link.length_ =
-                            link_attr_node.get_optional<std::uint64_t>(
-                                "length");
-                        link.title_ =
-                            link_attr_node.get_optional<std::string>("title");
-                        link.type_ =
-                            link_attr_node.get_optional<std::string>("type");
-
-                        const auto rel_node =
-                            link_attr_node.get_child_optional("rel");
-                        if (rel_node) {
-                            const std::string ref =
-                                rel_node->get_value<std::string>();
-                            if (ref == "alternate")
-                                link.rel_ = rel::alternate;
-                            else if (ref == "enclosure")
-                                link.rel_ = rel::enclosure;
-                            else if (ref == "related")
-                                link.rel_ = rel::related;
-                            else if (ref == "self")
-                                link.rel_ = rel::self;
-                            else
-                                link.rel_ = rel::via;
-                        }
-
-                        links.emplace_back(std::move(link));
-                    } else if (entry_child.first == "category") {
-                        const auto &category_attr_node =
-                            entry_child.second.get_child("<xmlattr>");
-
-                        categories.emplace_back(
-                            category_attr_node.get<std::string>("term"),
-                            category_attr_node.get_optional<std::string>(
-                                "scheme"),
-                            category_attr_node.get_optional<std::string>(
-                                "label"));
-                    } else if (entry_child.first == "contributor") {
-                        const auto &contributor_node = entry_child.second;
-
-                        contributors.emplace_back(
-                            contributor_node.get<std::string>("name"),
-                            contributor_node.get_optional<std::string>("email"),
-                            contributor_node.get_optional<std::string>("uri"));
-                    }
+        if (!authors.empty())
+            data.authors_.emplace(std::move(authors));
 
-                if (!authors.empty())
-                    entry.authors_.emplace(std::move(authors));
+        if (!links.empty())
+            data.links_.emplace(std::move(links));
 
-                if (!links.empty())
-                    entry.links_.emplace(std::move(links));
+        if (!categories.empty())
+            data.categories_.emplace(std::move(categories));
 
-                if (!categories.empty())
-                    entry.categories_.emplace(std::move(categories));
+        if (!contributors.empty())
+            data.contributors_.emplace(std::move(contributors));
 
-                if (!contributors.empty())
-                    entry.contributors_.emplace(std::move(contributors));
+        if (!extensions.empty())
+            data.extensions_.emplace(std::move(extensions));
+    }
 
-                data.entries_.emplace_back(std::move(entry));
+    entry parse_entry() {
+        entry entry;
+        bool has_id = false;
+        bool has_title = false;
+        std::vector<person> authors;
+        std::vector<link> links;
+        std::vector<category> categories;
+        std::vector<person> contributors;
+        std::vector<extension> extensions;
+
+        while (context_.child()) {
+            const auto name = atom_name();
+
+            if (name == "author") {
+                context_.append(authors, parse_person());
+            } else if (name == "link") {
+                context_.append(links, parse_link());
+            } else if (name == "category") {
+                context_.append(categories, parse_category());
+            } else if (name == "contributor") {
+                context_.append(contributors, parse_person());
+            } else if (name == "id" && !has_id) {
+                entry.id_ = context_.text();
+                has_id = true;
+            } else if (name == "title" && !has_title) {
+                entry.title_.type_ = text_type();
+                entry.title_.value_ = context_.text();
+                has_title = true;
+            } else if (name == "content" && !entry.content_) {
+                const auto type = text_type();
+                entry.content_.emplace(context_.text(), type);
+            } else if (name == "summary" && !entry.summary_) {
+                const auto type = text_type();
+                entry.summary_.emplace(context_.text(), type);
+            } else if (name == "rights" && !entry.rights_) {
+                const auto type = text_type();
+                entry.rights_.emplace(context_.text(), type);
+            } else if (!context_.extension(extensions)) {
+                context_.skip();
             }
+        }
+
+        if (!has_id)
+            detail::parse_context::missing("id");
+        if (!has_title)
+            detail::parse_context::missing("title");
 
         if (!authors.empty())
-            data.authors_.emplace(std::move(authors));
+            entry.authors_.emplace(std::move(authors));
 
         if (!links.empty())
-            data.links_.emplace(std::move(links));
+            entry.links_.emplace(std::move(links));
 
         if (!categories.empty())
-            data.categories_.emplace(std::move(categories));
+            entry.categories_.emplace(std::move(categories));
 
         if (!contributors.empty())
-            data.contributors_.emplace(std::move(contributors));
+            entry.contributors_.emplace(std::move(contributors));
+
+        if (!extensions.empty())
+            entry.extensions_.emplace(std::move(extensions));
+
+        return entry;
+    }
+
+    // The local name of the current element if it belongs to the Atom 1.0 or
+    // 0.3 namespace or to none, empty for elements of other namespaces.
+    boost::string_ref atom_name() {
+        const auto &reader = context_.reader();
+        const auto uri = reader.namespace_uri();
+        if (uri.empty() ? reader.prefix().empty()
+                        : uri == xmlns::atom || uri == xmlns::atom03)
+            return reader.local_name();
+
+        return {};
+    }
+
+    // The type attribute of a text construct, text if it is absent or unknown.
+    enum text::type text_type() {
+        const auto type = context_.attribute("type");
+        if (type) {
+            if (type.value() == "html")
+                return text::type::html;
+            else if (type.value() == "xhtml")
+                return text::type::xhtml;
+        }
+
+        return text::type::text;
+    }
+
+    person parse_person() {
+        boost::optional<std::string> name;
+        boost::optional<std::string> email;
+        boost::optional<std::string> uri;
+
+        while (context_.child()) {
+            const auto child = atom_name();
+
+            if (child == "name" && !name)
+                name = context_.text();
+            else if (child == "email" && !email)
+                email = context_.text();
+            else if (child == "uri" && !uri)
+                uri = context_.text();
+            else
+                context_.skip();
+        }
 
-        return std::move(data);
-    } catch (const std::exception &e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+        if (!name)
+            detail::parse_context::missing("name");
+
+        return {std::move(name.value()), std::move(email), std::move(uri)};
     }
 
-    return {};
+    link parse_link() {
+        if (context_.reader().attributes().empty())
+            detail::parse_context::missing("<xmlattr>");
+
+        link link;
+        link.href_ = context_.required_attribute("href");
+        link.href_lang_ = context_.attribute("hreflang");
+        const auto length = context_.attribute("length");
+        if (length)
+            link.length_ = detail::to_number<std::uint64_t>(length.value());
+        link.title_ = context_.attribute("title");
+        link.type_ = context_.attribute("type");
+
+        const auto rel_attr = context_.attribute("rel");
+        if (rel_attr) {
+            const std::string &ref = rel_attr.value();
+            if (ref == "alternate")
+                link.rel_ = rel::alternate;
+            else if (ref == "enclosure")
+                link.rel_ = rel::enclosure;
+            else if (ref == "related")
+                link.rel_ = rel::related;
+            else if (ref == "self")
+                link.rel_ = rel::self;
+            else
+                link.rel_ = rel::via;
+        }
+
+        context_.skip();
+
+        return link;
+    }
+
+    category parse_category() {
+        if (context_.reader().attributes().empty())
+            detail::parse_context::missing("<xmlattr>");
+
+        auto term = context_.required_attribute("term");
+        auto scheme = context_.attribute("scheme");
+        auto label = context_.attribute("label");
+        context_.skip();
+
+        return {std::move(term), std::move(scheme), std::move(label)};
+    }
+
+    // Exceptions of on_entry_ end the parse like parse errors, then parse()
+    // rethrows them instead of logging.
+    bool hand_over(entry &&built) {
+        try {
+            return (*on_entry_)(std::move(built));
+        } catch (...) {
+            callback_error_ = std::current_exception();
+            throw std::runtime_error("entry callback failed");
+        }
+    }
+
+    detail::parse_context context_;
+    // Set for parse_atom() with callbacks, entries are handed to it instead
+    // of being kept.
+    const std::function<bool(entry &&)> *on_entry_;
+    std::size_t entries_ = 0;
+    bool stopped_ = false; // By on_entry_.
+    std::exception_ptr callback_error_; // Thrown by on_entry_, for parse().
+    // Set for parse_atom() with a feed_state, unchanged entries are skipped.
+    detail::delta_tracker *delta_;
+};
+
+boost::optional<atom_data> parse_atom(const std::string &xml_str) {
+    return parser(xml_str, parse_options()).parse();
+}
+
+boost::optional<atom_data> parse_atom(const std::string &xml_str,
+                                      parse_stats &stats) {
+    parse_options options;
+    options.stats = &stats;
+
+    return parser(xml_str, options).parse();
+}
+
+boost::optional<atom_data> parse_atom(const std::string &xml_str,
+                                      const parse_options &options) {
+    return parser(xml_str, options).parse();
+}
+
+boost::optional<atom_delta> parse_atom(const std::string &xml_str,
+                                       const feed_state &previous,
+                                       const parse_options &options) {
+    detail::delta_tracker delta(previous);
+    auto data = parser(xml_str, options, nullptr, &delta).parse();
+    if (!data)
+        return {};
+
+    atom_delta result(std::move(data.value()));
+    result.changed = std::move(delta.changed());
+    result.unchanged = delta.unchanged_count();
+    result.state = delta.state();
+
+    return std::move(result);
+}
+
+bool parse_atom(const std::string &xml_str,
+                const std::function<void(atom_data &&)> &on_feed,
+                const std::function<bool(entry &&)> &on_entry,
+                const parse_options &options) {
+    auto data = parser(xml_str, options, &on_entry).parse();
+    if (!data)
+        return false;
+
+    if (on_feed)
+        on_feed(std::move(data.value()));
+
+    return true;
 }
 }
 }
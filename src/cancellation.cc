@@ -0,0 +1,79 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <feed/cancellation.h>
+
+namespace feed {
+std::size_t
+cancellation_token::subscribe(std::function<void()> callback) const {
+    if (!state_)
+        return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->cancelled.load(std::memory_order_relaxed)) {
+            const auto id = state_->next_id++;
+            state_->callbacks.emplace_back(id, std::move(callback));
+
+            return id;
+        }
+    }
+    callback();
+
+    return 0;
+}
+
+void cancellation_token::unsubscribe(std::size_t id) const {
+    if (!state_ || id == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto &callbacks = state_->callbacks;
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
+        if (it->first == id) {
+            callbacks.erase(it);
+            break;
+        }
+}
+
+void cancellation_source::cancel() {
+    std::vector<std::pair<std::size_t, std::function<void()>>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->cancelled.load(std::memory_order_relaxed))
+            return;
+
+        state_->cancelled.store(true, std::memory_order_release);
+        callbacks.swap(state_->callbacks);
+    }
+
+    // Outside the lock, a callback may well unsubscribe others.
+    for (const auto &callback : callbacks)
+        callback.second();
+}
+}
@@ -0,0 +1,327 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <feed/charset.h>
+
+// The SSE2 loop finds the first non-ASCII byte with __builtin_ctz.
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define FEED_PARSER_SSE2
+#endif
+
+namespace {
+// The UTF-8 encoding of each byte from 0x80 up.
+class high_half {
+  public:
+    // ISO-8859-1, where bytes are code points.
+    high_half() {
+        for (std::size_t i = 0; i < 128; ++i)
+            set(i, static_cast<std::uint16_t>(0x80 + i));
+    }
+    explicit high_half(const std::uint16_t (&code_points)[128]) {
+        for (std::size_t i = 0; i < 128; ++i)
+            set(i, code_points[i]);
+    }
+
+    void append(unsigned char byte, std::string &out) const {
+        const auto &entry = entries_[byte - 0x80];
+        out.append(entry.bytes, entry.size);
+    }
+
+  private:
+    void set(std::size_t i, std::uint16_t code) {
+        auto &entry = entries_[i];
+        if (code < 0x800) {
+            entry.bytes[0] = static_cast<char>(0xC0 | (code >> 6));
+            entry.bytes[1] = static_cast<char>(0x80 | (code & 0x3F));
+            entry.size = 2;
+        } else {
+            entry.bytes[0] = static_cast<char>(0xE0 | (code >> 12));
+            entry.bytes[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            entry.bytes[2] = static_cast<char>(0x80 | (code & 0x3F));
+            entry.size = 3;
+        }
+    }
+
+    struct entry {
+        char bytes[3];
+        std::uint8_t size;
+    };
+
+    entry entries_[128];
+};
+
+const high_half &iso_8859_1() {
+    static const high_half table;
+
+    return table;
+}
+
+const high_half &windows_1252() {
+    // 0x80 to 0x9F differ from ISO-8859-1, the five bytes Windows leaves
+    // undefined map to the C1 controls, as browsers do.
+    static const std::uint16_t code_points[128] = {
+        0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+        0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+        0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+        0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+        0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+        0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+        0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+        0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+        0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+        0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+        0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+        0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+        0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+        0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+        0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+        0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF};
+    static const high_half table(code_points);
+
+    return table;
+}
+
+// The length of a well-formed sequence starting with lead and the range of
+// its second byte, false if lead starts none.
+bool expected_sequence(unsigned char lead, std::size_t &length,
+                       unsigned char &low, unsigned char &high) {
+    low = 0x80;
+    high = 0xBF;
+
+    if (lead < 0x80)
+        length = 1;
+    else if (lead >= 0xC2 && lead <= 0xDF)
+        length = 2;
+    else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0)
+            low = 0xA0; // Overlong.
+        else if (lead == 0xED)
+            high = 0x9F; // Surrogates.
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0)
+            low = 0x90; // Overlong.
+        else if (lead == 0xF4)
+            high = 0x8F; // Past U+10FFFF.
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+// Length of the well-formed sequence at data, 0 if there is none.
+std::size_t sequence_length(const unsigned char *data, std::size_t size) {
+    std::size_t length;
+    unsigned char low;
+    unsigned char high;
+    if (!expected_sequence(data[0], length, low, high))
+        return 0;
+    if (length == 1)
+        return 1;
+
+    if (size < length || data[1] < low || data[1] > high)
+        return 0;
+    for (std::size_t i = 2; i < length; ++i)
+        if (data[i] < 0x80 || data[i] > 0xBF)
+            return 0;
+
+    return length;
+}
+
+// Length of the maximal subpart at data, which is not a well-formed
+// sequence: the longest prefix of one that it starts with, or its first
+// byte if that starts none.
+std::size_t maximal_subpart(const unsigned char *data, std::size_t size) {
+    std::size_t length;
+    unsigned char low;
+    unsigned char high;
+    if (!expected_sequence(data[0], length, low, high) || size < 2 ||
+        data[1] < low || data[1] > high)
+        return 1;
+
+    std::size_t i = 2;
+    while (i < length && i < size && data[i] >= 0x80 && data[i] <= 0xBF)
+        ++i;
+
+    return i;
+}
+
+bool equals_ignoring_case(boost::string_ref a, const char *b) {
+    const auto size = std::strlen(b);
+    if (a.size() != size)
+        return false;
+
+    for (std::size_t i = 0; i < size; ++i)
+        if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+            return false;
+
+    return true;
+}
+}
+
+namespace feed {
+boost::optional<charset> find_charset(boost::string_ref name) {
+    for (const char *alias : {"utf-8", "utf8", "us-ascii", "ascii"})
+        if (equals_ignoring_case(name, alias))
+            return charset::utf8;
+
+    for (const char *alias : {"iso-8859-1", "iso8859-1", "iso_8859-1",
+                              "latin1", "latin-1", "l1", "cp819"})
+        if (equals_ignoring_case(name, alias))
+            return charset::iso_8859_1;
+
+    for (const char *alias : {"windows-1252", "cp1252", "x-cp1252"})
+        if (equals_ignoring_case(name, alias))
+            return charset::windows_1252;
+
+    return {};
+}
+
+boost::string_ref declared_encoding(boost::string_ref document) {
+    if (document.starts_with("\xEF\xBB\xBF"))
+        document.remove_prefix(3);
+    if (!document.starts_with("<?xml"))
+        return {};
+
+    const auto end = document.find("?>");
+    if (end == boost::string_ref::npos)
+        return {};
+    document = document.substr(0, end);
+
+    auto pos = document.find("encoding");
+    if (pos == boost::string_ref::npos)
+        return {};
+    pos += 8;
+
+    while (pos < document.size() &&
+           (document[pos] == ' ' || document[pos] == '=' ||
+            document[pos] == '\t' || document[pos] == '\r' ||
+            document[pos] == '\n'))
+        ++pos;
+    if (pos == document.size() ||
+        (document[pos] != '"' && document[pos] != '\''))
+        return {};
+
+    const char quote = document[pos];
+    document.remove_prefix(pos + 1);
+    const auto close = document.find(quote);
+    if (close == boost::string_ref::npos)
+        return {};
+
+    return document.substr(0, close);
+}
+
+void to_utf8(charset from, boost::string_ref input, std::string &out) {
+    if (from == charset::utf8) {
+        out.append(input.data(), input.size());
+
+        return;
+    }
+
+    const high_half &table =
+        from == charset::iso_8859_1 ? iso_8859_1() : windows_1252();
+    const char *pos = input.data();
+    const char *const end = pos + input.size();
+
+    while (pos != end) {
+        const auto ascii =
+            ascii_length(pos, static_cast<std::size_t>(end - pos));
+        out.append(pos, ascii);
+        pos += ascii;
+
+        for (; pos != end && static_cast<unsigned char>(*pos) >= 0x80; ++pos)
+            table.append(static_cast<unsigned char>(*pos), out);
+    }
+}
+
+std::size_t ascii_length(const char *data, std::size_t size) {
+    std::size_t pos = 0;
+
+#ifdef FEED_PARSER_SSE2
+    for (; pos + 16 <= size; pos += 16) {
+        const int mask = _mm_movemask_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(data + pos)));
+        if (mask != 0)
+            return pos + static_cast<std::size_t>(__builtin_ctz(
+                             static_cast<unsigned int>(mask)));
+    }
+#endif
+
+    for (; pos + 8 <= size; pos += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + pos, 8);
+        if (word & 0x8080808080808080ULL)
+            break;
+    }
+
+    while (pos < size && static_cast<unsigned char>(data[pos]) < 0x80)
+        ++pos;
+
+    return pos;
+}
+
+std::size_t utf8_length(const char *data, std::size_t size) {
+    const auto bytes = reinterpret_cast<const unsigned char *>(data);
+    std::size_t pos = 0;
+
+    while (pos < size) {
+        pos += ascii_length(data + pos, size - pos);
+        while (pos < size && bytes[pos] >= 0x80) {
+            const auto length = sequence_length(bytes + pos, size - pos);
+            if (length == 0)
+                return pos;
+            pos += length;
+        }
+    }
+
+    return pos;
+}
+
+void repair_utf8(boost::string_ref input, std::string &out) {
+    const char *pos = input.data();
+    const char *const end = pos + input.size();
+
+    while (pos != end) {
+        const auto valid = utf8_length(pos, static_cast<std::size_t>(end - pos));
+        out.append(pos, valid);
+        pos += valid;
+        if (pos == end)
+            break;
+
+        out += "\xEF\xBF\xBD";
+        pos += maximal_subpart(reinterpret_cast<const unsigned char *>(pos),
+                               static_cast<std::size_t>(end - pos));
+    }
+}
+}
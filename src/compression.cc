@@ -0,0 +1,188 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <cstring>
+#include <feed/compression.h>
+#include <feed/log.h>
+#include <fstream>
+#include <vector>
+#include <zlib.h>
+
+namespace feed {
+struct inflater::state {
+    z_stream stream;
+    bool started = false;
+    bool finished = false;
+    bool failed = false;
+};
+
+inflater::inflater() : state_(new state) {
+    std::memset(&state_->stream, 0, sizeof(state_->stream));
+}
+
+inflater::~inflater() {
+    if (state_->started)
+        inflateEnd(&state_->stream);
+}
+
+bool inflater::inflate(const void *data, std::size_t size, std::string &out,
+                       std::size_t max_size) {
+    if (state_->failed)
+        return false;
+
+    auto next = static_cast<const unsigned char *>(data);
+    if (!state_->started) {
+        if (size == 0)
+            return true;
+
+        // 32 lets zlib detect gzip or zlib headers; anything else is taken
+        // for raw deflate, which some servers send as "deflate". A raw
+        // stream cannot start with 0x1f, its block type would be invalid.
+        const bool wrapped =
+            next[0] == 0x1f ||
+            ((next[0] & 0x0f) == 8 &&
+             (size < 2 || (next[0] * 256 + next[1]) % 31 == 0));
+        if (inflateInit2(&state_->stream, wrapped ? 15 + 32 : -15) != Z_OK) {
+            state_->failed = true;
+
+            return false;
+        }
+        state_->started = true;
+    }
+
+    auto &stream = state_->stream;
+    stream.next_in = const_cast<unsigned char *>(next);
+    stream.avail_in = static_cast<uInt>(size);
+
+    unsigned char buffer[16384];
+    while (stream.avail_in > 0 || !state_->finished) {
+        if (state_->finished) {
+            // Another gzip member may follow the one that ended, anything
+            // else is trailing garbage and ignored, as gunzip does.
+            if (!is_gzip(stream.next_in, stream.avail_in))
+                break;
+            if (inflateReset(&stream) != Z_OK) {
+                state_->failed = true;
+
+                return false;
+            }
+            state_->finished = false;
+        }
+
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+
+        const int result = ::inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END &&
+            result != Z_BUF_ERROR) {
+            state_->failed = true;
+
+            return false;
+        }
+
+        const auto produced = sizeof(buffer) - stream.avail_out;
+        out.append(reinterpret_cast<const char *>(buffer), produced);
+        if (max_size != 0 && out.size() > max_size) {
+            state_->failed = true;
+
+            return false;
+        }
+
+        if (result == Z_STREAM_END)
+            state_->finished = true;
+        else if (produced == 0 && stream.avail_in == 0)
+            break; // Waiting for more input.
+    }
+
+    return true;
+}
+
+bool inflater::finished() const { return state_->finished; }
+
+bool is_gzip(const void *data, std::size_t size) {
+    const auto bytes = static_cast<const unsigned char *>(data);
+
+    return size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b;
+}
+
+boost::optional<std::string> read_file(const std::string &path,
+                                       std::size_t max_size) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        log(log_level::error, "cannot open " + path);
+
+        return {};
+    }
+
+    std::vector<char> buffer(1 << 16);
+    std::string content;
+    std::unique_ptr<inflater> inflater;
+    bool first = true;
+
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const auto size = static_cast<std::size_t>(file.gcount());
+        if (size == 0)
+            break;
+
+        if (first) {
+            if (is_gzip(buffer.data(), size))
+                inflater.reset(new class inflater);
+            first = false;
+        }
+
+        if (!inflater)
+            content.append(buffer.data(), size);
+        else if (!inflater->inflate(buffer.data(), size, content, max_size) &&
+                 (max_size == 0 || content.size() <= max_size)) {
+            log(log_level::error, "corrupt gzip data in " + path);
+
+            return {};
+        }
+        if (max_size != 0 && content.size() > max_size) {
+            log(log_level::error, path + " is larger than " +
+                                      std::to_string(max_size) + " bytes");
+
+            return {};
+        }
+    }
+
+    if (file.bad()) {
+        log(log_level::error, "cannot read " + path);
+
+        return {};
+    }
+    if (inflater && !inflater->finished()) {
+        log(log_level::error, "truncated gzip data in " + path);
+
+        return {};
+    }
+
+    return content;
+}
+}
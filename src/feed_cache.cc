@@ -0,0 +1,246 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <feed/feed_cache.h>
+#include <feed/log.h>
+
+namespace feed {
+static std::chrono::seconds ttl(const rss::rss_data &feed,
+                                const feed_cache_config &config) {
+    if (!feed.ttl())
+        return config.default_ttl;
+
+    return std::min<std::chrono::seconds>(
+        std::chrono::minutes(feed.ttl().value()), config.max_ttl);
+}
+
+static std::chrono::seconds ttl(const atom::atom_data &,
+                                const feed_cache_config &config) {
+    return std::min(config.default_ttl, config.max_ttl);
+}
+
+static boost::optional<rss::rss_data> parse(const std::string &xml,
+                                            const parse_options &options,
+                                            const rss::rss_data *) {
+    return rss::parse_rss(xml, options);
+}
+
+static boost::optional<atom::atom_data> parse(const std::string &xml,
+                                              const parse_options &options,
+                                              const atom::atom_data *) {
+    return atom::parse_atom(xml, options);
+}
+
+template <typename Feed>
+feed_cache<Feed>::feed_cache(feed_cache_config config)
+    : config_(std::move(config)) {}
+
+template <typename Feed>
+typename feed_cache<Feed>::feed_ptr
+feed_cache<Feed>::find(const std::string &uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    bool fresh;
+    auto feed = lookup(uri, fresh);
+
+    return fresh ? feed : nullptr;
+}
+
+template <typename Feed>
+void feed_cache<Feed>::insert(const std::string &uri, feed_ptr feed) {
+    if (!feed)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    store(uri, std::move(feed));
+}
+
+template <typename Feed>
+pplx::task<typename feed_cache<Feed>::feed_ptr>
+feed_cache<Feed>::get_async(const std::string &uri, const loader &load) {
+    pplx::task_completion_event<feed_ptr> loaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        bool fresh;
+        auto feed = lookup(uri, fresh);
+        if (fresh)
+            return pplx::task_from_result(feed);
+
+        const auto it = loading_.find(uri);
+        if (it != loading_.end())
+            return it->second;
+        // In the table before load can complete, which may be at once.
+        loading_.emplace(uri, pplx::task<feed_ptr>(loaded));
+    }
+
+    pplx::task<feed_ptr> task;
+    try {
+        task = load(uri);
+    } catch (const std::exception &e) {
+        log(log_level::error, uri + ": " + e.what());
+        task = pplx::task_from_result(feed_ptr());
+    }
+
+    task.then([this, uri, loaded](pplx::task<feed_ptr> task) {
+        feed_ptr feed;
+        try {
+            feed = task.get();
+        } catch (const std::exception &e) {
+            log(log_level::error, uri + ": " + e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            loading_.erase(uri);
+            if (feed)
+                store(uri, feed);
+        }
+        loaded.set(feed);
+    });
+
+    return pplx::task<feed_ptr>(loaded);
+}
+
+template <typename Feed>
+pplx::task<typename feed_cache<Feed>::feed_ptr>
+feed_cache<Feed>::get_async(const std::string &uri, fetcher &fetcher,
+                            const parse_options &options,
+                            const fetch_options &fetch) {
+    return get_async(uri, [this, &fetcher, options,
+                           fetch](const std::string &uri) {
+        feed_ptr stale;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bool fresh;
+            stale = lookup(uri, fresh);
+        }
+
+        // Without the feed a 304 would leave nothing to return.
+        auto unconditional = fetch;
+        if (!stale)
+            unconditional.conditional = false;
+
+        const auto parser = [](const std::string &xml,
+                               const parse_options &options) {
+            return parse(xml, options, static_cast<const Feed *>(nullptr));
+        };
+
+        return fetcher.fetch_and_parse_async(uri, parser, options,
+                                             unconditional)
+            .then([stale](const parsed_fetch<Feed> &parsed) -> feed_ptr {
+                switch (parsed.status) {
+                case fetch_status::not_modified:
+                case fetch_status::failed:
+                case fetch_status::timed_out:
+                    return stale;
+                default:
+                    return parsed.feed;
+                }
+            });
+    });
+}
+
+template <typename Feed> bool feed_cache<Feed>::erase(const std::string &uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = index_.find(uri);
+    if (it == index_.end())
+        return false;
+
+    bytes_ -= it->second->bytes;
+    entries_.erase(it->second);
+    index_.erase(it);
+
+    return true;
+}
+
+template <typename Feed> void feed_cache<Feed>::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+template <typename Feed> std::size_t feed_cache<Feed>::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return index_.size();
+}
+
+template <typename Feed> std::size_t feed_cache<Feed>::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return bytes_;
+}
+
+template <typename Feed>
+typename feed_cache<Feed>::feed_ptr
+feed_cache<Feed>::lookup(const std::string &uri, bool &fresh) {
+    fresh = false;
+
+    const auto it = index_.find(uri);
+    if (it == index_.end())
+        return nullptr;
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    fresh = clock::now() < it->second->expires;
+
+    return it->second->feed;
+}
+
+template <typename Feed>
+void feed_cache<Feed>::store(const std::string &uri, feed_ptr feed) {
+    const auto it = index_.find(uri);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    const auto bytes = sizeof(Feed) + feed->memory_usage() + uri.size();
+    if (bytes > config_.max_bytes)
+        return;
+
+    while (bytes_ + bytes > config_.max_bytes) {
+        bytes_ -= entries_.back().bytes;
+        index_.erase(entries_.back().uri);
+        entries_.pop_back();
+    }
+
+    const auto expires = clock::now() + ttl(*feed, config_);
+    entries_.push_front(entry{uri, std::move(feed), bytes, expires});
+    index_.emplace(uri, entries_.begin());
+    bytes_ += bytes;
+}
+
+template class feed_cache<rss::rss_data>;
+template class feed_cache<atom::atom_data>;
+}
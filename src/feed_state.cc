@@ -0,0 +1,56 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <feed/feed_state.h>
+
+namespace feed {
+static bool key_less(const feed_state::entry &left,
+                     const feed_state::entry &right) {
+    return left.first < right.first;
+}
+
+feed_state::feed_state(std::vector<entry> entries)
+    : entries_(std::move(entries)) {
+    std::stable_sort(entries_.begin(), entries_.end(), key_less);
+    entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                               [](const entry &left, const entry &right) {
+                                   return left.first == right.first;
+                               }),
+                   entries_.end());
+}
+
+boost::optional<std::uint64_t> feed_state::find(std::uint64_t key) const {
+    const auto it = std::lower_bound(entries_.begin(), entries_.end(),
+                                     entry(key, 0), key_less);
+    if (it == entries_.end() || it->first != key)
+        return {};
+
+    return it->second;
+}
+}
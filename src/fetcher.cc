@@ -0,0 +1,761 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "item_scanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <feed/compression.h>
+#include <feed/fetcher.h>
+#include <feed/fingerprint.h>
+#include <feed/log.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace utility;
+
+// ASCII lower case, bytes above 0x7F are kept.
+static void to_lower(std::string &str) {
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+}
+
+static boost::optional<std::string>
+header(const web::http::http_response &response, const string_t &name) {
+    const auto &headers = response.headers();
+    const auto it = headers.find(name);
+    if (it == headers.end() || it->second.empty())
+        return {};
+
+    return conversions::to_utf8string(it->second);
+}
+
+struct body_reader {
+    std::unique_ptr<feed::inflater> inflater; // Null unless compressed.
+    std::vector<unsigned char> buffer = std::vector<unsigned char>(1 << 16);
+    std::string content;
+    std::function<void()> progress; // Called before each chunk is read.
+    // Null unless fetch_options::known_item is set.
+    std::unique_ptr<feed::detail::item_scanner> scanner;
+    bool stopped = false; // At a known item, before the end of the body.
+    std::size_t max_bytes = 0; // See fetch_options::max_body_bytes.
+};
+
+// Appends the body to state->content chunk by chunk as it arrives, inflating
+// it if need be, the compressed data is never held as a whole. The bytes are
+// kept as they are, whatever the charset. Stops early once the scanner meets
+// a known item, fails as soon as the content grows past state->max_bytes.
+static bool too_large(const body_reader &state) {
+    return state.max_bytes != 0 && state.content.size() > state.max_bytes;
+}
+
+static pplx::task<void>
+read_chunks(const concurrency::streams::istream &body,
+            const std::shared_ptr<body_reader> &state) {
+    if (state->progress)
+        state->progress();
+
+    return body.streambuf()
+        .getn(state->buffer.data(), state->buffer.size())
+        .then([body, state](std::size_t size) -> pplx::task<void> {
+            if (size == 0) {
+                if (state->inflater && !state->inflater->finished())
+                    throw std::runtime_error("truncated compressed body");
+
+                return pplx::task_from_result();
+            }
+
+            if (!state->inflater)
+                state->content.append(
+                    reinterpret_cast<const char *>(state->buffer.data()),
+                    size);
+            else if (!state->inflater->inflate(state->buffer.data(), size,
+                                               state->content,
+                                               state->max_bytes) &&
+                     !too_large(*state))
+                throw std::runtime_error("corrupt compressed body");
+            if (too_large(*state))
+                throw std::runtime_error(
+                    "body larger than " + std::to_string(state->max_bytes) +
+                    " bytes");
+
+            if (state->scanner && state->scanner->scan(state->content)) {
+                state->stopped = true;
+
+                return pplx::task_from_result();
+            }
+
+            return read_chunks(body, state);
+        });
+}
+
+static pplx::task<void> read_body(const web::http::http_response &response,
+                                  const std::shared_ptr<body_reader> &state) {
+    auto encoding =
+        header(response, web::http::header_names::content_encoding);
+    if (encoding)
+        to_lower(encoding.value());
+
+    if (encoding && encoding.value() != "identity") {
+        if (encoding.value() != "gzip" && encoding.value() != "x-gzip" &&
+            encoding.value() != "deflate")
+            throw std::runtime_error("unsupported Content-Encoding: " +
+                                     encoding.value());
+
+        state->inflater.reset(new feed::inflater);
+    } else {
+        const auto length = response.headers().content_length();
+        if (state->max_bytes != 0 && length > 0 &&
+            static_cast<std::size_t>(length) > state->max_bytes)
+            throw std::runtime_error("body larger than " +
+                                     std::to_string(state->max_bytes) +
+                                     " bytes");
+        if (length > 0)
+            state->content.reserve(static_cast<std::size_t>(length));
+    }
+
+    return read_chunks(response.body(), state);
+}
+
+// The charset parameter of a Content-Type, lower-cased and unquoted.
+static std::string charset(const std::string &content_type) {
+    std::string lower(content_type);
+    to_lower(lower);
+
+    auto pos = lower.find("charset=");
+    if (pos == std::string::npos)
+        return {};
+    pos += 8;
+
+    auto end = lower.find(';', pos);
+    if (end == std::string::npos)
+        end = lower.size();
+    while (end > pos && (lower[end - 1] == ' ' || lower[end - 1] == '"' ||
+                         lower[end - 1] == '\'' || lower[end - 1] == '\t'))
+        --end;
+    while (pos < end && (lower[pos] == '"' || lower[pos] == '\''))
+        ++pos;
+
+    return lower.substr(pos, end - pos);
+}
+
+namespace feed {
+struct fetcher::pool {
+    using clock = std::chrono::steady_clock;
+
+    // The state of one fetch, shared with its continuations.
+    struct request_state {
+        std::string key; // Of the host.
+        pplx::cancellation_token_source source;
+        clock::time_point deadline = clock::time_point::max(); // Total.
+        std::chrono::milliseconds connect_timeout{0};
+        // Set once the timer cancelled source.
+        std::atomic<bool> timed_out{false};
+        std::size_t subscription = 0; // To fetch_options::cancel.
+        // Of a 429 or 503, applied to the host once the request is over.
+        boost::optional<std::chrono::seconds> retry_after;
+
+        // Locked.
+        bool admitted = false; // Counted in its host's in_flight.
+        bool armed = false;
+        std::multimap<clock::time_point,
+                      std::shared_ptr<request_state>>::iterator timer;
+    };
+
+    struct waiter {
+        pplx::task_completion_event<void> event;
+        std::shared_ptr<request_state> request;
+    };
+
+    struct host {
+        std::shared_ptr<web::http::client::http_client> client;
+        clock::time_point last_used;
+        std::size_t in_flight = 0;
+        double tokens = 0;
+        clock::time_point refilled;
+        clock::time_point paused_until;
+        std::deque<waiter> queue;
+    };
+
+    explicit pool(fetcher_config config)
+        : config(std::move(config)),
+          limited(this->config.max_requests_per_host != 0 ||
+                  this->config.requests_per_second > 0) {
+        client_config.set_timeout(this->config.timeout);
+        client_config.set_validate_certificates(
+            this->config.validate_certificates);
+        if (this->config.proxy)
+            client_config.set_proxy(web::web_proxy(
+                conversions::to_string_t(this->config.proxy.value())));
+    }
+
+    // The host of uri, created if need be. Locked.
+    host &find(const std::string &key, const web::uri &uri,
+               clock::time_point now,
+               std::vector<std::shared_ptr<web::http::client::http_client>>
+                   &closed) {
+        const auto it = hosts.find(key);
+        if (it != hosts.end()) {
+            it->second.last_used = now;
+
+            return it->second;
+        }
+
+        const auto busy = [](const host &host) {
+            return host.in_flight != 0 || !host.queue.empty();
+        };
+
+        for (auto idle = hosts.begin(); idle != hosts.end();)
+            if (!busy(idle->second) &&
+                now - idle->second.last_used >= config.idle_timeout) {
+                closed.push_back(std::move(idle->second.client));
+                idle = hosts.erase(idle);
+            } else {
+                ++idle;
+            }
+
+        while (hosts.size() >= config.max_hosts) {
+            auto oldest = hosts.end();
+            for (auto other = hosts.begin(); other != hosts.end(); ++other)
+                if (!busy(other->second) &&
+                    (oldest == hosts.end() ||
+                     other->second.last_used < oldest->second.last_used))
+                    oldest = other;
+            if (oldest == hosts.end())
+                break;
+
+            closed.push_back(std::move(oldest->second.client));
+            hosts.erase(oldest);
+        }
+
+        host &created = hosts[key];
+        created.client = std::make_shared<web::http::client::http_client>(
+            uri.authority(), client_config);
+        created.last_used = now;
+        created.tokens = static_cast<double>(config.burst);
+        created.refilled = now;
+
+        return created;
+    }
+
+    // Whether a request to host may start now, counted as started if so.
+    // Locked.
+    bool admit(host &host, clock::time_point now) {
+        if (!limited)
+            return true;
+        if (config.max_requests_per_host != 0 &&
+            host.in_flight >= config.max_requests_per_host)
+            return false;
+        if (now < host.paused_until)
+            return false;
+
+        if (config.requests_per_second > 0) {
+            const std::chrono::duration<double> elapsed = now - host.refilled;
+            host.tokens = std::min(
+                static_cast<double>(config.burst),
+                host.tokens + elapsed.count() * config.requests_per_second);
+            host.refilled = now;
+            if (host.tokens < 1)
+                return false;
+            host.tokens -= 1;
+        }
+
+        ++host.in_flight;
+
+        return true;
+    }
+
+    // When host may be admitted again, if that depends on time only. Locked.
+    boost::optional<clock::time_point> ready_at(const host &host) const {
+        if (config.max_requests_per_host != 0 &&
+            host.in_flight >= config.max_requests_per_host)
+            return {}; // Until a request completes.
+
+        auto at = std::max(host.paused_until, host.refilled);
+        if (config.requests_per_second > 0 && host.tokens < 1)
+            at = std::max(
+                at, host.refilled +
+                        std::chrono::duration_cast<clock::duration>(
+                            std::chrono::duration<double>(
+                                (1 - host.tokens) /
+                                config.requests_per_second)));
+
+        return at;
+    }
+
+    static bool cancelled(const request_state &request) {
+        return request.source.get_token().is_canceled();
+    }
+
+    // Starts the dispatcher unless it runs. Locked.
+    void start() {
+        if (!dispatcher.joinable() && !stopping)
+            dispatcher = std::thread(&pool::dispatch, this);
+    }
+
+    // Cancels request at the earlier of at and its total deadline. Locked.
+    void arm(const std::shared_ptr<request_state> &request, clock::time_point at) {
+        disarm(*request);
+
+        at = std::min(at, request->deadline);
+        if (at == clock::time_point::max())
+            return;
+
+        const auto first = timers.empty() || at < timers.begin()->first;
+        request->timer = timers.emplace(at, request);
+        request->armed = true;
+        start();
+        if (first)
+            wake.notify_one();
+    }
+
+    // Arms the connect timeout of request as it leaves the queue of its
+    // host. Locked.
+    void connecting(const std::shared_ptr<request_state> &request,
+                    clock::time_point now) {
+        arm(request, request->connect_timeout.count() != 0
+                         ? now + request->connect_timeout
+                         : clock::time_point::max());
+    }
+
+    void disarm(request_state &request) {
+        if (request.armed) {
+            timers.erase(request.timer);
+            request.armed = false;
+        }
+    }
+
+    // Gives the slot of request back to its host, if it holds one.
+    void release(const std::shared_ptr<request_state> &request) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!request->admitted)
+                return;
+            request->admitted = false;
+
+            const auto it = hosts.find(request->key);
+            if (it != hosts.end()) {
+                --it->second.in_flight;
+                if (request->retry_after)
+                    it->second.paused_until =
+                        clock::now() + request->retry_after.value();
+            }
+        }
+        wake.notify_one();
+    }
+
+    // Called by the last continuation of request.
+    void finish(const std::shared_ptr<request_state> &request,
+                const cancellation_token &cancel) {
+        release(request);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            disarm(*request);
+        }
+        cancel.unsubscribe(request->subscription);
+    }
+
+    // Fails queued requests that were cancelled. Called outside the lock,
+    // after request->source has been cancelled.
+    void swept() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sweep = true;
+        }
+        wake.notify_one();
+    }
+
+    // Starts the queued requests as their hosts allow, one per host per
+    // round, fails those cancelled while queued and cancels requests past
+    // their deadline.
+    void dispatch() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopping) {
+            const auto now = clock::now();
+            std::vector<std::shared_ptr<request_state>> expired;
+            std::vector<pplx::task_completion_event<void>> ready;
+            std::vector<pplx::task_completion_event<void>> dropped;
+
+            while (!timers.empty() && timers.begin()->first <= now) {
+                const auto request = timers.begin()->second;
+                timers.erase(timers.begin());
+                request->armed = false;
+                request->timed_out = true;
+                expired.push_back(request);
+            }
+
+            if (sweep) {
+                sweep = false;
+                for (const auto &key : waiting) {
+                    auto &queue = hosts[key].queue;
+                    for (auto it = queue.begin(); it != queue.end();)
+                        if (it->request->timed_out || cancelled(*it->request)) {
+                            dropped.push_back(std::move(it->event));
+                            it = queue.erase(it);
+                        } else {
+                            ++it;
+                        }
+                }
+            }
+
+            auto next = clock::time_point::max();
+            for (auto n = waiting.size(); n != 0; --n) {
+                const auto key = std::move(waiting.front());
+                waiting.pop_front();
+
+                auto &host = hosts[key];
+                if (!host.queue.empty() && admit(host, now)) {
+                    host.queue.front().request->admitted = true;
+                    connecting(host.queue.front().request, now);
+                    ready.push_back(std::move(host.queue.front().event));
+                    host.queue.pop_front();
+                }
+                if (!host.queue.empty()) {
+                    const auto at = ready_at(host);
+                    if (at)
+                        next = std::min(next, at.value());
+                    waiting.push_back(key);
+                }
+            }
+            if (!timers.empty())
+                next = std::min(next, timers.begin()->first);
+
+            if (!expired.empty() || !ready.empty() || !dropped.empty()) {
+                // Cancelling may run continuations that take the lock.
+                lock.unlock();
+                for (const auto &request : expired)
+                    request->source.cancel();
+                for (const auto &event : ready)
+                    event.set();
+                for (const auto &event : dropped)
+                    event.set_exception(pplx::task_canceled());
+                lock.lock();
+                if (!expired.empty())
+                    sweep = true;
+            } else if (next == clock::time_point::max()) {
+                wake.wait(lock);
+            } else {
+                wake.wait_until(lock, next);
+            }
+        }
+    }
+
+    const fetcher_config config;
+    const bool limited;
+    web::http::client::http_client_config client_config;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::unordered_map<std::string, host> hosts;
+    std::deque<std::string> waiting; // Hosts with queued requests, in turn.
+    std::multimap<clock::time_point, std::shared_ptr<request_state>> timers;
+    bool sweep = false; // Whether queued requests may have been cancelled.
+    bool stopping = false;
+    std::thread dispatcher; // Started on the first queued or timed request.
+};
+
+fetcher::fetcher(fetcher_config config)
+    : pool_(std::make_shared<pool>(std::move(config))) {}
+
+fetcher::~fetcher() {
+    std::vector<pplx::task_completion_event<void>> queued;
+    {
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+        pool_->stopping = true;
+        for (auto &host : pool_->hosts)
+            for (auto &waiter : host.second.queue)
+                queued.push_back(std::move(waiter.event));
+        // The timers hold their requests, which are no longer cancelled.
+        for (auto &timer : pool_->timers)
+            timer.second->armed = false;
+        pool_->timers.clear();
+    }
+    pool_->wake.notify_one();
+    if (pool_->dispatcher.joinable())
+        pool_->dispatcher.join();
+
+    for (const auto &event : queued)
+        event.set_exception(std::runtime_error("fetcher destroyed"));
+}
+
+fetch_result fetcher::fetch(const std::string &uri,
+                            const fetch_options &options) {
+    return fetch_async(uri, options).get();
+}
+
+pplx::task<fetch_result> fetcher::fetch_async(const std::string &uri,
+                                              const fetch_options &options) {
+    using clock = pool::clock;
+
+    const auto &config = pool_->config;
+    const auto start = clock::now();
+    const auto state = std::make_shared<pool::request_state>();
+    if (options.total_timeout.count() != 0)
+        state->deadline = start + options.total_timeout;
+
+    std::shared_ptr<web::http::client::http_client> client;
+    pplx::task<void> admitted;
+    web::http::http_request request(web::http::methods::GET);
+    boost::optional<validators> cached;
+
+    try {
+        const web::uri target(conversions::to_string_t(uri));
+        state->key = conversions::to_utf8string(target.scheme()) + "://" +
+                     conversions::to_utf8string(target.host()) + ':' +
+                     std::to_string(target.port());
+
+        request.set_request_uri(target.resource());
+        if (!config.user_agent.empty())
+            request.headers().add(web::http::header_names::user_agent,
+                                  conversions::to_string_t(config.user_agent));
+        if (config.compression)
+            request.headers().add(web::http::header_names::accept_encoding,
+                                  U("gzip, deflate"));
+
+        if (config.validators && options.conditional) {
+            cached = config.validators->find(uri);
+            if (cached && cached->etag)
+                request.headers().add(
+                    web::http::header_names::if_none_match,
+                    conversions::to_string_t(cached->etag.value()));
+            if (cached && cached->last_modified)
+                request.headers().add(
+                    web::http::header_names::if_modified_since,
+                    conversions::to_string_t(cached->last_modified.value()));
+        }
+
+        // Clients are destroyed, and their connections closed, outside the
+        // lock. Requests still running on one keep it alive until they end.
+        std::vector<std::shared_ptr<web::http::client::http_client>> closed;
+        std::lock_guard<std::mutex> lock(pool_->mutex);
+
+        auto &host = pool_->find(state->key, target, start, closed);
+        client = host.client;
+
+        state->connect_timeout = options.connect_timeout;
+        if (host.queue.empty() && pool_->admit(host, start)) {
+            state->admitted = pool_->limited;
+            pool_->connecting(state, start);
+            admitted = pplx::task_from_result();
+        } else {
+            // Waiting in the queue counts against the total timeout only.
+            pool_->arm(state, clock::time_point::max());
+            pool::waiter waiter;
+            waiter.request = state;
+            if (host.queue.empty())
+                pool_->waiting.push_back(state->key);
+            host.queue.push_back(waiter);
+            admitted = pplx::create_task(waiter.event);
+            pool_->start();
+            pool_->wake.notify_one();
+        }
+    } catch (const web::uri_exception &e) {
+        if (log_enabled(log_level::error))
+            log(log_level::error, uri + ": " + e.what());
+
+        return pplx::task_from_result(fetch_result());
+    } catch (const std::invalid_argument &e) {
+        if (log_enabled(log_level::error))
+            log(log_level::error, uri + ": " + e.what());
+
+        return pplx::task_from_result(fetch_result());
+    }
+
+    // The continuations hold what they need by value, the fetcher may be
+    // gone by the time they run.
+    const auto pool = pool_;
+    const auto cache = config.validators;
+    const auto fingerprints = config.fingerprints;
+    const auto cancel = options.cancel;
+    const auto read_timeout = options.read_timeout;
+    const auto known_item = options.known_item;
+    const auto max_retry_after = config.max_retry_after;
+    const auto max_body_bytes = options.max_body_bytes;
+
+    const std::weak_ptr<fetcher::pool> weak = pool_;
+    state->subscription = cancel.subscribe([weak, state]() {
+        state->source.cancel();
+        const auto pool = weak.lock();
+        if (pool)
+            pool->swept();
+    });
+
+    return admitted
+        .then([client, request, state]() {
+            return client->request(request, state->source.get_token());
+        })
+        .then([uri, pool, state, cached, cache, fingerprints, read_timeout,
+               known_item, max_retry_after,
+               max_body_bytes](web::http::http_response response)
+                  -> pplx::task<fetch_result> {
+            fetch_result result;
+            result.status_code = response.status_code();
+
+            // 429 Too Many Requests has no constant in cpprest.
+            if (result.status_code == 429 ||
+                result.status_code ==
+                    web::http::status_codes::ServiceUnavailable) {
+                const auto value =
+                    header(response, web::http::header_names::retry_after);
+                if (value && !value->empty() &&
+                    value->find_first_not_of("0123456789") == std::string::npos)
+                    // Longer values would overflow the clock.
+                    state->retry_after =
+                        value->size() < 10
+                            ? std::min(std::chrono::seconds(
+                                           std::stoll(value.value())),
+                                       max_retry_after)
+                            : max_retry_after;
+            }
+
+            if (result.status_code == web::http::status_codes::NotModified &&
+                cached) {
+                result.status = fetch_status::not_modified;
+
+                return pplx::task_from_result(result);
+            }
+
+            if (result.status_code != web::http::status_codes::OK) {
+                if (log_enabled(log_level::warning))
+                    log(log_level::warning,
+                        "GET " + uri + ": status " +
+                            std::to_string(result.status_code));
+
+                return pplx::task_from_result(result);
+            }
+
+            const auto content_type =
+                header(response, web::http::header_names::content_type);
+            if (content_type) {
+                result.content_type = content_type.value();
+                result.charset = charset(content_type.value());
+            }
+
+            validators fresh;
+            fresh.etag = header(response, web::http::header_names::etag);
+            fresh.last_modified =
+                header(response, web::http::header_names::last_modified);
+
+            const auto body = std::make_shared<body_reader>();
+            // From now on the timer runs from one chunk to the next.
+            body->progress = [pool, state, read_timeout]() {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->arm(state, read_timeout.count() != 0
+                                     ? clock::now() + read_timeout
+                                     : clock::time_point::max());
+            };
+            if (known_item)
+                body->scanner.reset(new detail::item_scanner(known_item));
+            body->max_bytes = max_body_bytes;
+
+            return read_body(response, body)
+                .then([uri, cached, cache, fingerprints, result, fresh, body,
+                       state]() mutable -> fetch_result {
+                    result.body = std::move(body->content);
+                    result.status = fetch_status::ok;
+                    // A cut body would never match the fingerprint of a
+                    // whole one.
+                    if (fingerprints && !body->stopped) {
+                        result.fingerprint =
+                            normalized_fingerprint(result.body);
+                        fresh.fingerprint = result.fingerprint;
+                        if (cached && cached->fingerprint &&
+                            cached->fingerprint.value() == result.fingerprint) {
+                            result.status = fetch_status::not_modified;
+                            std::string().swap(result.body);
+                        }
+                    }
+                    // Everything new has been received, the validators
+                    // hold. A cut body has no fingerprint of its own, the one
+                    // of the last whole body stands.
+                    if (cache) {
+                        if (body->stopped) {
+                            const auto previous = cache->find(uri);
+                            fresh.fingerprint =
+                                previous ? previous->fingerprint : boost::none;
+                        }
+                        cache->store(uri, std::move(fresh));
+                    }
+                    if (body->stopped) {
+                        result.partial = true;
+                        // Closes the connection instead of draining it.
+                        state->source.cancel();
+                    }
+
+                    return result;
+                });
+        })
+        .then([uri, pool, state, cancel](pplx::task<fetch_result> task) {
+            pool->finish(state, cancel);
+
+            fetch_result result;
+            try {
+                return task.get();
+            } catch (const std::exception &e) {
+                if (state->timed_out) {
+                    result.status = fetch_status::timed_out;
+                    if (log_enabled(log_level::warning))
+                        log(log_level::warning, "GET " + uri + ": timed out");
+                } else if (pool::cancelled(*state)) {
+                    result.status = fetch_status::cancelled;
+                } else if (log_enabled(log_level::error)) {
+                    log(log_level::error, "GET " + uri + ": " + e.what());
+                }
+            }
+
+            return result;
+        });
+}
+
+std::size_t fetcher::hosts() const {
+    std::lock_guard<std::mutex> lock(pool_->mutex);
+
+    return pool_->hosts.size();
+}
+
+void fetcher::clear() {
+    std::vector<std::shared_ptr<web::http::client::http_client>> closed;
+    std::lock_guard<std::mutex> lock(pool_->mutex);
+
+    for (auto it = pool_->hosts.begin(); it != pool_->hosts.end();)
+        if (it->second.in_flight == 0 && it->second.queue.empty()) {
+            closed.push_back(std::move(it->second.client));
+            it = pool_->hosts.erase(it);
+        } else {
+            ++it;
+        }
+}
+}
@@ -0,0 +1,216 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <feed/extension.h>
+#include <feed/fingerprint.h>
+#include <feed/hash.h>
+#include <vector>
+
+namespace feed {
+static bool space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Whether the tag at pos opens a name element.
+template <std::size_t N>
+static bool opens(const char *pos, const char *end, const char (&name)[N]) {
+    const std::size_t size = N - 1;
+
+    return static_cast<std::size_t>(end - pos) > size + 1 &&
+           std::memcmp(pos + 1, name, size) == 0 &&
+           (pos[size + 1] == '>' || pos[size + 1] == '/' ||
+            space(pos[size + 1]));
+}
+
+// What is known of the head of a document, ahead of the first item or entry,
+// where the dates of the channel or feed are.
+struct head {
+    bool open = true;
+    // Bound to the Atom namespace by the elements of the head.
+    std::vector<boost::string_ref> atom_prefixes;
+};
+
+// Adds the prefixes that the attributes of a start tag bind to Atom.
+static void bind_prefixes(boost::string_ref attributes, head &head) {
+    static const char declaration[] = "xmlns:";
+    const char *pos = attributes.begin();
+    const char *const end = attributes.end();
+
+    for (;;) {
+        pos = std::search(pos, end, declaration,
+                          declaration + sizeof(declaration) - 1);
+        if (pos == end)
+            return;
+        pos += sizeof(declaration) - 1;
+
+        const char *const prefix = pos;
+        while (pos != end && *pos != '=' && !space(*pos))
+            ++pos;
+        const boost::string_ref name(prefix,
+                                     static_cast<std::size_t>(pos - prefix));
+        while (pos != end && (*pos == '=' || space(*pos)))
+            ++pos;
+        if (pos == end || (*pos != '"' && *pos != '\''))
+            continue;
+
+        const char quote = *pos++;
+        const char *const value = pos;
+        pos = std::find(pos, end, quote);
+        const boost::string_ref uri(value,
+                                    static_cast<std::size_t>(pos - value));
+        if (uri == xmlns::atom || uri == xmlns::atom03)
+            head.atom_prefixes.push_back(name);
+    }
+}
+
+// The end of the name of the element opened at pos, in the head.
+static const char *in_head(const char *pos, const char *end, head &head) {
+    const char *name_end = pos + 1;
+    while (name_end != end && !space(*name_end) && *name_end != '/' &&
+           *name_end != '>')
+        ++name_end;
+    boost::string_ref name(pos + 1,
+                           static_cast<std::size_t>(name_end - pos - 1));
+    if (name.empty() || name[0] == '!' || name[0] == '?')
+        return nullptr;
+
+    const char *const tag_end = std::find(name_end, end, '>');
+    bind_prefixes(boost::string_ref(name_end, static_cast<std::size_t>(
+                                                  tag_end - name_end)),
+                  head);
+
+    // As the parsers read them, RSS elements in no namespace and Atom ones
+    // in the default namespace or under a prefix bound to it.
+    const auto colon = name.find(':');
+    const bool prefixed = colon != boost::string_ref::npos;
+    if (prefixed) {
+        if (std::find(head.atom_prefixes.begin(), head.atom_prefixes.end(),
+                      name.substr(0, colon)) == head.atom_prefixes.end())
+            return nullptr;
+        name = name.substr(colon + 1);
+    }
+
+    if (name == "item" || name == "entry") {
+        head.open = false;
+
+        return nullptr;
+    }
+    if (name == "updated" ||
+        (!prefixed && (name == "pubDate" || name == "lastBuildDate")))
+        return name_end;
+
+    return nullptr;
+}
+
+// The end of the name of the element opened at pos if its content is left
+// out, nullptr otherwise. The dates of the channel or feed are only ignored
+// in its head, those of items are content.
+static const char *ignored(const char *pos, const char *end, head &head) {
+    if (head.open)
+        return in_head(pos, end, head);
+    if (end - pos > 1 && pos[1] == 'l' && opens(pos, end, "lastBuildDate"))
+        return pos + sizeof("<lastBuildDate") - 1;
+
+    return nullptr;
+}
+
+// Past the element opened at pos, whose name ends at name_end, or end if it
+// is not closed.
+static const char *skip_element(const char *pos, const char *end,
+                                const char *name_end) {
+    const char *const name = pos + 1;
+    const auto size = static_cast<std::size_t>(name_end - name);
+
+    const char *tag_end = std::find(pos, end, '>');
+    if (tag_end == end)
+        return end;
+    if (tag_end[-1] == '/')
+        return tag_end + 1;
+
+    static const char close[] = "</";
+    for (pos = tag_end;;) {
+        pos = std::search(pos, end, close, close + sizeof(close) - 1);
+        if (pos == end)
+            return end;
+        pos += sizeof(close) - 1;
+        if (static_cast<std::size_t>(end - pos) > size &&
+            std::memcmp(pos, name, size) == 0 &&
+            (pos[size] == '>' || space(pos[size])))
+            break;
+    }
+    tag_end = std::find(pos, end, '>');
+
+    return tag_end == end ? end : tag_end + 1;
+}
+
+std::uint64_t raw_fingerprint(boost::string_ref document) {
+    return hash64(document);
+}
+
+std::uint64_t normalized_fingerprint(boost::string_ref document) {
+    hasher hash;
+    // Kept bytes are gathered here, hashing them a few at a time is slow.
+    char buffer[4096];
+    std::size_t buffered = 0;
+    const auto keep = [&](char c) {
+        if (buffered == sizeof(buffer)) {
+            hash.update(boost::string_ref(buffer, buffered));
+            buffered = 0;
+        }
+        buffer[buffered++] = c;
+    };
+
+    const char *pos = document.data();
+    const char *const end = pos + document.size();
+    // As if the document began right after a tag.
+    char previous = '>';
+    head head;
+
+    while (pos != end) {
+        if (space(*pos)) {
+            const auto next = std::find_if_not(pos, end, space);
+            if (next != end && *next != '<' && *next != '>' &&
+                previous != '>' && previous != '<')
+                keep(' ');
+            pos = next;
+        } else if (const char *name_end =
+                       *pos == '<' ? ignored(pos, end, head) : nullptr) {
+            pos = skip_element(pos, end, name_end);
+            previous = '>';
+        } else {
+            previous = *pos++;
+            keep(previous);
+        }
+    }
+    hash.update(boost::string_ref(buffer, buffered));
+
+    return hash.digest();
+}
+}
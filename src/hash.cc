@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <feed/hash.h>
+
+namespace feed {
+static const std::uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+static const std::uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const std::uint64_t prime3 = 0x165667B19E3779F9ULL;
+static const std::uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+static const std::uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+static std::uint64_t rotl(std::uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian loads, memcpy compiles to a single instruction.
+static std::uint64_t read64(const char *data) {
+    std::uint64_t value;
+    std::memcpy(&value, data, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static std::uint32_t read32(const char *data) {
+    std::uint32_t value;
+    std::memcpy(&value, data, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static std::uint64_t round(std::uint64_t accumulator, std::uint64_t input) {
+    return rotl(accumulator + input * prime2, 31) * prime1;
+}
+
+static std::uint64_t merge(std::uint64_t hash, std::uint64_t accumulator) {
+    return (hash ^ round(0, accumulator)) * prime1 + prime4;
+}
+
+// Folds the last bytes, fewer than 32, into hash and mixes it.
+static std::uint64_t finish(std::uint64_t hash, const char *pos,
+                            const char *end) {
+    for (; end - pos >= 8; pos += 8)
+        hash = rotl(hash ^ round(0, read64(pos)), 27) * prime1 + prime4;
+    if (end - pos >= 4) {
+        hash = rotl(hash ^ (read32(pos) * prime1), 23) * prime2 + prime3;
+        pos += 4;
+    }
+    for (; pos != end; ++pos)
+        hash = rotl(hash ^ (static_cast<unsigned char>(*pos) * prime5), 11) *
+               prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+static std::uint64_t converge(const std::uint64_t (&lanes)[4]) {
+    std::uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) +
+                         rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    for (const auto lane : lanes)
+        hash = merge(hash, lane);
+
+    return hash;
+}
+
+static void stripe(std::uint64_t (&lanes)[4], const char *data) {
+    lanes[0] = round(lanes[0], read64(data));
+    lanes[1] = round(lanes[1], read64(data + 8));
+    lanes[2] = round(lanes[2], read64(data + 16));
+    lanes[3] = round(lanes[3], read64(data + 24));
+}
+
+std::uint64_t hash64(boost::string_ref data, std::uint64_t seed) {
+    const char *pos = data.data();
+    const char *const end = pos + data.size();
+    std::uint64_t hash;
+
+    if (data.size() >= 32) {
+        std::uint64_t lanes[4] = {seed + prime1 + prime2, seed + prime2, seed,
+                                  seed - prime1};
+        for (; end - pos >= 32; pos += 32)
+            stripe(lanes, pos);
+
+        hash = converge(lanes);
+    } else {
+        hash = seed + prime5;
+    }
+
+    return finish(hash + data.size(), pos, end);
+}
+
+hasher::hasher(std::uint64_t seed)
+    : seed_(seed), lanes_{seed + prime1 + prime2, seed + prime2, seed,
+                          seed - prime1} {}
+
+hasher &hasher::update(boost::string_ref data) {
+    const char *pos = data.data();
+    const char *const end = pos + data.size();
+    length_ += data.size();
+
+    if (buffered_ != 0) {
+        const auto size = std::min<std::size_t>(32 - buffered_, data.size());
+        std::memcpy(buffer_ + buffered_, pos, size);
+        buffered_ += size;
+        pos += size;
+        if (buffered_ < 32)
+            return *this;
+
+        stripe(lanes_, buffer_);
+        buffered_ = 0;
+    }
+
+    for (; end - pos >= 32; pos += 32)
+        stripe(lanes_, pos);
+
+    buffered_ = static_cast<std::size_t>(end - pos);
+    std::memcpy(buffer_, pos, buffered_);
+
+    return *this;
+}
+
+std::uint64_t hasher::digest() const {
+    const auto hash = length_ >= 32 ? converge(lanes_) : seed_ + prime5;
+
+    return finish(hash + length_, buffer_, buffer_ + buffered_);
+}
+
+boost::string_ref identity(const rss::item &item) {
+    if (item.guid() && !item.guid()->value().empty())
+        return item.guid()->value();
+    if (item.link())
+        return item.link().value();
+
+    return {};
+}
+
+boost::string_ref identity(const atom::entry &entry) { return entry.id(); }
+}
@@ -0,0 +1,209 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <feed/interval_estimator.h>
+
+// FNV-1a, stable across runs so that histories can be stored.
+static std::uint64_t hash(const std::string &str) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static std::int64_t seconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               time.time_since_epoch())
+        .count();
+}
+
+namespace feed {
+interval_estimator::interval_estimator(estimator_config config)
+    : config_(std::move(config)) {}
+
+std::size_t interval_estimator::observe(arrival_history &history,
+                                        const rss::rss_data &feed,
+                                        clock::time_point at) const {
+    const auto now = seconds(at);
+    std::vector<item> items;
+    items.reserve(feed.items().size());
+
+    for (const auto &entry : feed.items()) {
+        const std::string *id = nullptr;
+        if (entry.guid())
+            id = &entry.guid()->value();
+        else if (entry.link())
+            id = &entry.link().value();
+        else if (entry.title())
+            id = &entry.title().value();
+
+        std::int64_t time = 0;
+        if (entry.pub_date())
+            time = std::min(now, static_cast<std::int64_t>(
+                                     entry.pub_date()->time_since_epoch().count()));
+
+        items.push_back(item{id ? hash(*id) : 0, time});
+    }
+
+    return learn(history, items, now);
+}
+
+std::size_t interval_estimator::observe(arrival_history &history,
+                                        const atom::atom_data &feed,
+                                        clock::time_point at) const {
+    std::vector<item> items;
+    items.reserve(feed.entries().size());
+
+    for (const auto &entry : feed.entries())
+        items.push_back(item{hash(entry.id()), 0});
+
+    return learn(history, items, seconds(at));
+}
+
+void interval_estimator::unchanged(arrival_history &history) const {
+    if (history.idle_polls < UINT16_MAX)
+        ++history.idle_polls;
+}
+
+std::chrono::seconds
+interval_estimator::interval(const arrival_history &history) const {
+    double interval = static_cast<double>(config_.default_interval.count());
+    if (history.samples >= config_.min_samples)
+        interval = history.mean_gap / config_.polls_per_item;
+
+    interval *= std::pow(config_.backoff, history.idle_polls);
+    interval = std::max(interval,
+                        static_cast<double>(config_.min_interval.count()));
+    interval = std::min(interval,
+                        static_cast<double>(config_.max_interval.count()));
+
+    return std::chrono::seconds(static_cast<std::int64_t>(interval));
+}
+
+void interval_estimator::sample(arrival_history &history, float gap) const {
+    history.mean_gap =
+        history.samples == 0
+            ? gap
+            : history.mean_gap + config_.smoothing * (gap - history.mean_gap);
+    if (history.samples < UINT16_MAX)
+        ++history.samples;
+}
+
+std::size_t interval_estimator::learn(arrival_history &history,
+                                      const std::vector<item> &items,
+                                      std::int64_t now) const {
+    if (items.empty()) {
+        unchanged(history);
+
+        return 0;
+    }
+
+    const bool first = history.polled == 0;
+
+    // The items listed outside the first and last items of the last poll, or
+    // all of them the first time. If one of them is gone, the items that were
+    // listed with it went on past the end it was at. If both are gone, the
+    // dated items are new if dated after the newest one seen and the undated
+    // ones are all new.
+    std::size_t front = items.size(), back = items.size();
+    if (!first)
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (front == items.size() && items[i].id == history.front_id)
+                front = i;
+            if (items[i].id == history.back_id)
+                back = i;
+        }
+
+    std::size_t begin = items.size(), end = 0;
+    if (front != items.size() && back != items.size()) {
+        begin = std::min(front, back);
+        end = std::max(front, back) + 1;
+    } else if (front != items.size()) {
+        begin = front;
+        end = items.size();
+    } else if (back != items.size()) {
+        begin = 0;
+        end = back + 1;
+    }
+
+    std::vector<std::int64_t> dated;
+    std::size_t undated = 0;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const auto time = items[i].time;
+        if (begin <= i && i < end)
+            continue;
+        if (!first && begin == items.size() && time != 0 &&
+            time <= history.newest)
+            continue;
+
+        if (time != 0)
+            dated.push_back(time);
+        else
+            ++undated;
+    }
+
+    history.front_id = items.front().id;
+    history.back_id = items.back().id;
+
+    if (dated.empty() && undated == 0) {
+        unchanged(history);
+
+        return 0;
+    }
+
+    // Dated items give the gaps between their dates, from the newest dated
+    // one seen before if any.
+    std::sort(dated.begin(), dated.end());
+    std::int64_t previous = history.newest;
+    for (const auto time : dated) {
+        if (previous != 0)
+            sample(history, static_cast<float>(
+                                std::max<std::int64_t>(time - previous, 0)));
+        previous = time;
+    }
+    if (!dated.empty())
+        history.newest = std::max(history.newest, dated.back());
+
+    // Undated items arrived one after another since the last poll that found
+    // items, the first poll only tells that they exist.
+    if (undated != 0 && !first)
+        sample(history, static_cast<float>(std::max<std::int64_t>(
+                            now - history.polled, 0)) /
+                            static_cast<float>(undated));
+
+    history.polled = now;
+    history.idle_polls = 0;
+
+    return dated.size() + undated;
+}
+}
@@ -0,0 +1,189 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "item_scanner.h"
+#include <feed/log.h>
+#include <feed/xml_reader.h>
+
+namespace feed {
+namespace detail {
+static bool is_item(const xml_reader &reader) {
+    const auto name = reader.local_name();
+
+    return name == "item" || name == "entry";
+}
+
+bool item_scanner::scan(std::string &document) {
+    if (done_)
+        return false;
+
+    try {
+        if (!started_ && !find_first(document))
+            return false;
+
+        return scan_items(document);
+    } catch (const xml_error &e) {
+        // Cut short in the middle of a token, the next chunk completes it.
+        if (base_ + e.offset() + 1 >= document.size())
+            return false;
+
+        // Anything else would fail again at the same place on every chunk,
+        // the parse reports it later on.
+        done_ = true;
+        if (log_enabled(log_level::warning))
+            log(log_level::warning,
+                std::string("known_item: no longer scanning, ") + e.what());
+    }
+
+    return false;
+}
+
+// Looks for the start of the first item and the names of its ancestors.
+bool item_scanner::find_first(const std::string &document) {
+    base_ = 0;
+    xml_reader reader(document.data(), document.data() + document.size());
+
+    for (;;) {
+        const auto before = reader.offset();
+        const auto token = reader.next();
+        if (token == xml_reader::token::end_document)
+            return false;
+        if (token != xml_reader::token::start_element ||
+            reader.depth() < 2 || !is_item(reader))
+            continue;
+
+        const auto path = reader.path();
+        std::size_t begin = 0;
+        for (auto slash = path.find('/'); slash != std::string::npos;
+             slash = path.find('/', begin)) {
+            open_.push_back(path.substr(begin, slash - begin));
+            begin = slash + 1;
+        }
+
+        started_ = true;
+        checkpoint_ = before;
+
+        return true;
+    }
+}
+
+// Reads the elements after checkpoint_ one at a time, each at the top of a
+// reader of its own: the end tag of their parent would fail a reader that
+// has no open element, and the document may have been reallocated since the
+// last call.
+bool item_scanner::scan_items(std::string &document) {
+    for (;;) {
+        auto next = checkpoint_;
+        while (next < document.size() &&
+               (document[next] == ' ' || document[next] == '\t' ||
+                document[next] == '\n' || document[next] == '\r'))
+            ++next;
+        if (next == document.size())
+            return false;
+        if (document.compare(next, 2, "</") == 0) {
+            done_ = true;
+
+            return false;
+        }
+        // Text between the items, which a reader without an open element
+        // rejects, is passed over.
+        if (document[next] != '<') {
+            const auto bracket = document.find('<', next);
+            checkpoint_ =
+                bracket == std::string::npos ? document.size() : bracket;
+            continue;
+        }
+
+        base_ = next;
+        xml_reader reader(document.data() + next,
+                          document.data() + document.size());
+        const auto token = reader.next();
+        if (token == xml_reader::token::end_document)
+            return false;
+        if (token != xml_reader::token::start_element) {
+            checkpoint_ = next + reader.offset();
+            continue;
+        }
+
+        if (!is_item(reader)) {
+            reader.skip();
+            checkpoint_ = next + reader.offset();
+            continue;
+        }
+
+        // The first guid, or link, of an RSS item, the id of an Atom entry,
+        // as the parsers keep them.
+        std::string id;
+        std::string link;
+        bool has_id = false;
+        bool has_link = false;
+        std::string *target = nullptr;
+        for (;;) {
+            const auto inner = reader.next();
+            if (inner == xml_reader::token::start_element &&
+                reader.depth() == 2) {
+                const auto name = reader.local_name();
+                target = nullptr;
+                if ((name == "guid" || name == "id") && !has_id) {
+                    target = &id;
+                    has_id = true;
+                } else if (name == "link" && !has_link) {
+                    target = &link;
+                    has_link = true;
+                }
+            } else if (inner == xml_reader::token::text && target &&
+                       reader.depth() == 2) {
+                if (reader.cdata())
+                    target->append(reader.text().data(), reader.text().size());
+                else
+                    decode_xml(reader.text(), *target);
+            } else if (inner == xml_reader::token::end_element) {
+                if (reader.depth() == 0)
+                    break;
+                if (reader.depth() == 1)
+                    target = nullptr;
+            } else if (inner == xml_reader::token::end_document) {
+                return false;
+            }
+        }
+
+        const auto &key = id.empty() ? link : id;
+        if (!key.empty() && known_(key)) {
+            document.resize(next);
+            for (auto name = open_.rbegin(); name != open_.rend(); ++name)
+                document += "</" + *name + '>';
+            done_ = true;
+
+            return true;
+        }
+
+        checkpoint_ = next + reader.offset();
+    }
+}
+}
+}
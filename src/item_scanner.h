@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace feed {
+namespace detail {
+// Follows a document as it is downloaded and finds the first item, or Atom
+// entry, whose guid, link if it has none, or id is known. Each call to scan()
+// only looks at what has arrived since the last complete item.
+class item_scanner {
+  public:
+    explicit item_scanner(std::function<bool(const std::string &)> known)
+        : known_(std::move(known)) {}
+
+    // Returns true once a known item has been met, document then ends right
+    // before it, with the elements still open at that point closed.
+    bool scan(std::string &document);
+
+  private:
+    bool find_first(const std::string &document);
+    bool scan_items(std::string &document);
+
+    std::function<bool(const std::string &)> known_;
+    bool started_ = false; // The first item has been found.
+    bool done_ = false;    // No more items will follow.
+    std::size_t checkpoint_ = 0; // Where the next item may start.
+    std::size_t base_ = 0; // Where the reader in use starts.
+    std::vector<std::string> open_; // The elements holding the items.
+};
+}
+}
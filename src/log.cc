@@ -0,0 +1,173 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <feed/log.h>
+#include <memory>
+
+namespace {
+struct sink {
+    feed::log_handler handler;
+    feed::log_level level;
+    std::uint32_t max_per_second;
+};
+
+// Read with std::atomic_load() on every message so that logging threads never
+// wait on each other, replaced as a whole by set_log_handler().
+std::shared_ptr<const sink> current_sink;
+std::atomic<bool> has_sink(false);
+
+// The second messages are counted in, truncated to 32 bits, and the number
+// of them in the lower 32, one word so that a message is counted in the
+// second it is checked against and none is lost when the second turns.
+std::atomic<std::uint64_t> rate(0);
+
+void deliver(const sink &sink, feed::log_level level,
+             const std::string &message) {
+    try {
+        sink.handler(level, message);
+    } catch (...) {
+        // A failing handler must not turn a logged problem into a new one.
+    }
+}
+}
+
+namespace feed {
+void set_log_handler(log_handler handler, log_level level,
+                     std::uint32_t max_per_second) {
+    std::shared_ptr<const sink> next;
+    if (handler)
+        next = std::make_shared<const sink>(
+            sink{std::move(handler), level, max_per_second});
+
+    has_sink.store(static_cast<bool>(next));
+    std::atomic_store(&current_sink, next);
+    rate.store(0);
+}
+
+bool log_enabled(log_level level) {
+    if (!has_sink.load(std::memory_order_relaxed))
+        return false;
+
+    const auto sink = std::atomic_load(&current_sink);
+
+    return sink && level >= sink->level;
+}
+
+void log(log_level level, const std::string &message) {
+    if (!has_sink.load(std::memory_order_relaxed))
+        return;
+
+    const auto sink = std::atomic_load(&current_sink);
+    if (!sink || level < sink->level)
+        return;
+
+    if (sink->max_per_second != 0) {
+        const auto now = static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+
+        auto state = rate.load();
+        std::uint32_t count;
+        bool turned;
+        do {
+            turned = static_cast<std::uint32_t>(state >> 32) != now;
+            count = turned ? 0 : static_cast<std::uint32_t>(state);
+        } while (!rate.compare_exchange_weak(
+            state, static_cast<std::uint64_t>(now) << 32 |
+                       (count == UINT32_MAX ? count : count + 1)));
+
+        const auto previous = static_cast<std::uint32_t>(state);
+        if (turned && previous > sink->max_per_second)
+            deliver(*sink, log_level::warning,
+                    std::to_string(previous - sink->max_per_second) +
+                        " log messages were suppressed");
+
+        if (count >= sink->max_per_second)
+            return;
+    }
+
+    deliver(*sink, level, message);
+}
+
+async_log_handler::async_log_handler(log_handler target, std::size_t capacity)
+    : target_(std::move(target)), capacity_(capacity),
+      thread_(&async_log_handler::run, this) {}
+
+async_log_handler::~async_log_handler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_one();
+    thread_.join();
+}
+
+void async_log_handler::operator()(log_level level,
+                                   const std::string &message) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= capacity_) {
+            ++dropped_;
+
+            return;
+        }
+        queue_.emplace_back(level, message);
+    }
+    ready_.notify_one();
+}
+
+std::uint64_t async_log_handler::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return dropped_;
+}
+
+void async_log_handler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;) {
+        ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty())
+            return;
+
+        auto message = std::move(queue_.front());
+        queue_.pop_front();
+
+        lock.unlock();
+        try {
+            target_(message.first, message.second);
+        } catch (...) {
+        }
+        lock.lock();
+    }
+}
+}
@@ -0,0 +1,665 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <boost/optional.hpp>
+#include <chrono>
+#include <feed/charset.h>
+#include <feed/feed_state.h>
+#include <feed/hash.h>
+#include <feed/log.h>
+#include <feed/parse_options.h>
+#include <feed/xml_reader.h>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace feed {
+namespace detail {
+// Identifies an element for delta parsing, see parse_context::hashes().
+struct element_hashes {
+    std::uint64_t key;
+    std::uint64_t content;
+    std::size_t end; // Offset just past its end tag.
+};
+
+// Walks an xml_reader on behalf of parse_rss() and parse_atom(). With
+// FEED_PARSER_STATS defined it also attributes the elapsed time to the parse
+// phases and counts the allocations made for the result, without it the
+// bookkeeping below compiles to nothing.
+class parse_context {
+  public:
+    enum class phase : std::uint8_t { tokenize, dates, decode, build };
+
+    // Charges the time spent in its scope to a phase.
+    class timed {
+      public:
+#ifdef FEED_PARSER_STATS
+        timed(parse_context &context, phase phase)
+            : context_(context), previous_(context.enter(phase)) {}
+        ~timed() { context_.enter(previous_); }
+
+      private:
+        parse_context &context_;
+        phase previous_;
+#else
+        timed(parse_context &, phase) {}
+#endif
+    };
+
+    parse_context(const std::string &xml_str, const parse_options &options)
+        : document_(xml_str),
+          reader_(xml_str.data(), xml_str.data() + xml_str.size()),
+          stats_(options.stats), extensions_(options.extensions),
+          charset_(document_charset(xml_str, options.charset)),
+          utf8_(options.utf8), cancel_(options.cancel),
+          deadline_(options.deadline),
+          interruptible_(options.cancel.cancellable() || options.deadline),
+          limits_(options.limits) {
+        reader_.set_max_depth(limits_.max_depth);
+#ifdef FEED_PARSER_STATS
+        last_ = std::chrono::steady_clock::now();
+#endif
+    }
+
+    xml_reader &reader() { return reader_; }
+
+    // Called before the first token, fails documents over max_document_bytes
+    // or already cancelled, then checks the UTF-8.
+    void begin() {
+        if (limits_.max_document_bytes != 0 &&
+            document_.size() > limits_.max_document_bytes)
+            throw std::runtime_error("document larger than max_document_bytes");
+
+        check_interrupted();
+        check_utf8();
+    }
+
+    // Checks the document against parse_options::utf8 in one pass, throws if
+    // it is ill-formed and the policy is reject. Documents converted from
+    // another charset are well-formed by construction.
+    void check_utf8() {
+        if (utf8_ == utf8_policy::pass_through || charset_ != charset::utf8)
+            return;
+
+        const timed scope(*this, phase::decode);
+        const auto valid = utf8_length(document_.data(), document_.size());
+        if (valid == document_.size())
+            return;
+
+        if (utf8_ == utf8_policy::reject)
+            throw xml_error("ill-formed UTF-8", valid);
+
+        repair_ = true;
+    }
+
+    // Whether every string of the result is guaranteed to be valid UTF-8.
+    bool valid_utf8() const {
+        return utf8_ != utf8_policy::pass_through || charset_ != charset::utf8;
+    }
+
+    xml_reader::token next() {
+        if (interruptible_ && ++tokens_ % check_interval == 0)
+            check_interrupted();
+
+        const timed scope(*this, phase::tokenize);
+
+        return reader_.next();
+    }
+
+    // Throws if the parse has been cancelled or is past its deadline.
+    void check_interrupted() const {
+        if (cancel_.cancelled())
+            throw std::runtime_error("cancelled");
+        if (deadline_ && std::chrono::steady_clock::now() >= deadline_.value())
+            throw std::runtime_error("deadline exceeded");
+    }
+
+    // Advances to the next child element of the current element, returns
+    // false once its end tag has been consumed instead.
+    bool child() {
+        for (;;)
+            switch (next()) {
+            case xml_reader::token::start_element:
+                return true;
+            case xml_reader::token::end_element:
+            case xml_reader::token::end_document:
+                return false;
+            case xml_reader::token::text:
+                break;
+            }
+    }
+
+    void skip() {
+        const timed scope(*this, phase::tokenize);
+
+        reader_.skip();
+    }
+
+    // Skips the current element, ending at hashes().end.
+    void skip_to(std::size_t offset) { reader_.skip_to(offset); }
+
+    // The hash of the text of the first of the keys child elements found in
+    // the current element, e.g. guid then link, of its bytes if it has none,
+    // and the hash of its bytes from its start tag to its end tag. Reads
+    // ahead with a reader of its own, nothing is built.
+    element_hashes hashes(std::initializer_list<boost::string_ref> keys) {
+        const timed scope(*this, phase::tokenize);
+        const auto begin = reader_.element_offset();
+        xml_reader ahead(document_.data() + begin,
+                         document_.data() + document_.size());
+        ahead.next();
+
+        std::vector<std::string> found(keys.size());
+        std::string *target = nullptr;
+        for (;;) {
+            const auto token = ahead.next();
+            if (token == xml_reader::token::start_element &&
+                ahead.depth() == 2) {
+                target = nullptr;
+                std::size_t index = 0;
+                for (const auto key : keys) {
+                    if (ahead.local_name() == key && found[index].empty())
+                        target = &found[index];
+                    ++index;
+                }
+            } else if (token == xml_reader::token::text && target &&
+                       ahead.depth() == 2) {
+                if (ahead.cdata())
+                    target->append(ahead.text().data(), ahead.text().size());
+                else
+                    decode_xml(ahead.text(), *target);
+            } else if (token == xml_reader::token::end_element) {
+                if (ahead.depth() == 0)
+                    break;
+                if (ahead.depth() == 1)
+                    target = nullptr;
+            } else if (token == xml_reader::token::end_document) {
+                break;
+            }
+        }
+
+        element_hashes hashes;
+        hashes.end = begin + ahead.offset();
+        hashes.content = hash64(document_.substr(begin, ahead.offset()));
+        hashes.key = hashes.content;
+        for (const auto &key : found)
+            if (!key.empty()) {
+                hashes.key = hash64(key);
+                break;
+            }
+
+        return hashes;
+    }
+
+    // The decoded character data directly inside the current element, child
+    // elements are skipped. Consumes the end tag.
+    std::string text() {
+        std::string value;
+        bool whole = true; // Until truncated by max_field_bytes.
+
+        for (;;)
+            switch (next()) {
+            case xml_reader::token::text: {
+                if (!whole)
+                    break;
+
+                const timed scope(*this, phase::decode);
+                const auto capacity = value.capacity();
+
+                whole = decode_field(reader_.text(), reader_.cdata(), value);
+                allocated(capacity, value.capacity());
+                break;
+            }
+            case xml_reader::token::start_element:
+                skip();
+                break;
+            case xml_reader::token::end_element:
+            case xml_reader::token::end_document:
+                return value;
+            }
+    }
+
+    // An attribute of the current start element.
+    boost::optional<std::string> attribute(boost::string_ref name) {
+        const auto raw = reader_.attribute_value(name);
+        if (!raw)
+            return {};
+
+        const timed scope(*this, phase::decode);
+        std::string value;
+        decode_field(raw.value(), false, value);
+        allocated(0, value.capacity());
+
+        return std::move(value);
+    }
+
+    std::string required_attribute(boost::string_ref name) {
+        auto value = attribute(name);
+        if (!value)
+            missing("<xmlattr>." + name.to_string());
+
+        return std::move(value.value());
+    }
+
+    // If the current element belongs to a registered namespace, parses it into
+    // an extension, appends it to out unless its handler rejects it and
+    // returns true. Returns false, leaving the element alone, otherwise.
+    bool extension(std::vector<feed::extension> &out) {
+        if (!extensions_)
+            return false;
+
+        const auto uri = reader_.namespace_uri();
+        if (uri.empty())
+            return false;
+
+        const auto handler = extensions_->find(uri);
+        if (!handler)
+            return false;
+
+        feed::extension element = parse_extension(uri);
+        if (!*handler || (*handler)(element))
+            append(out, std::move(element));
+
+        return true;
+    }
+
+    // Whether another item may follow the count already parsed, throws past
+    // parse_limits::max_items under fail.
+    bool more_items(std::size_t count) const {
+        if (limits_.max_items == 0 || count < limits_.max_items)
+            return true;
+        if (limits_.policy == limit_policy::fail)
+            throw std::runtime_error("more than max_items items");
+
+        return false;
+    }
+
+    template <typename T, typename... Args>
+    void append(std::vector<T> &vector, Args &&... args) {
+        const auto capacity = vector.capacity();
+        vector.emplace_back(std::forward<Args>(args)...);
+        allocated(capacity, vector.capacity());
+    }
+
+    template <typename Function>
+    auto date(Function function, const std::string &str)
+        -> decltype(function(str)) {
+        const timed scope(*this, phase::dates);
+
+        auto time = function(str);
+#ifdef FEED_PARSER_STATS
+        if (stats_ && !time)
+            ++stats_->invalid_dates;
+#endif
+        return time;
+    }
+
+    [[noreturn]] static void missing(const std::string &name) {
+        throw std::runtime_error("No such node (" + name + ")");
+    }
+
+    void item() {
+#ifdef FEED_PARSER_STATS
+        if (stats_)
+            ++stats_->items;
+#endif
+    }
+
+    // Called once the document has been parsed or has failed to parse.
+    void finish(bool failed) {
+#ifdef FEED_PARSER_STATS
+        if (stats_) {
+            enter(phase::build);
+            stats_->bytes = reader_.offset();
+            if (failed)
+                stats_->failed_element = reader_.path();
+        }
+#else
+        (void)failed;
+#endif
+    }
+
+  private:
+    static charset document_charset(const std::string &xml_str,
+                                    const std::string &transport) {
+        if (xml_str.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            return charset::utf8;
+
+        const auto declared = declared_encoding(xml_str);
+        for (const auto name : {boost::string_ref(transport), declared}) {
+            if (name.empty())
+                continue;
+
+            const auto found = find_charset(name);
+            if (found)
+                return found.value();
+
+            if (log_enabled(log_level::warning))
+                log(log_level::warning, "unsupported encoding " +
+                                            name.to_string() +
+                                            ", parsed as UTF-8");
+        }
+
+        return charset::utf8;
+    }
+
+    // Appends raw text or an attribute value, converted to UTF-8 and with
+    // its references decoded unless it is CDATA. ASCII is never copied twice.
+    void decode(boost::string_ref raw, bool cdata, std::string &out) {
+        if ((charset_ != charset::utf8 || repair_) &&
+            ascii_length(raw.data(), raw.size()) != raw.size()) {
+            std::string &converted = cdata ? out : scratch_;
+            if (!cdata)
+                scratch_.clear();
+
+            if (repair_)
+                repair_utf8(raw, converted);
+            else
+                to_utf8(charset_, raw, converted);
+
+            if (cdata)
+                return;
+            raw = scratch_;
+        }
+
+        if (cdata)
+            out.append(raw.data(), raw.size());
+        else
+            decode_xml(raw, out);
+    }
+
+    // decode() bounded by parse_limits::max_field_bytes for the whole of
+    // out. Only a prefix of raw that may fit is decoded at a time, so an
+    // oversized value is never copied in full. Returns false once out has
+    // been truncated, nothing more may be appended to it then.
+    bool decode_field(boost::string_ref raw, bool cdata, std::string &out) {
+        const auto max = limits_.max_field_bytes;
+        if (max == 0) {
+            decode(raw, cdata, out);
+
+            return true;
+        }
+
+        while (!raw.empty() && out.size() < max) {
+            auto size = std::min(raw.size(), max - out.size());
+            if (size < raw.size()) {
+                // Neither a reference nor a character is split, references
+                // decode to less than they take.
+                if (!cdata) {
+                    const auto amp = raw.substr(0, size).rfind('&');
+                    if (amp != boost::string_ref::npos) {
+                        // Longer ones are not references, kept verbatim.
+                        const auto semicolon = raw.substr(amp, 16).find(';');
+                        if (semicolon != boost::string_ref::npos)
+                            size = std::max(size, amp + semicolon + 1);
+                    }
+                }
+                if (charset_ == charset::utf8)
+                    while (size < raw.size() &&
+                           (static_cast<unsigned char>(raw[size]) & 0xC0) ==
+                               0x80)
+                        ++size;
+            }
+
+            decode(raw.substr(0, size), cdata, out);
+            raw.remove_prefix(size);
+        }
+
+        if (raw.empty() && out.size() <= max)
+            return true;
+        if (limits_.policy == limit_policy::fail)
+            throw std::runtime_error("value longer than max_field_bytes");
+
+        auto size = max;
+        while (size != 0 &&
+               (static_cast<unsigned char>(out[size]) & 0xC0) == 0x80)
+            --size;
+        out.resize(size);
+
+        return false;
+    }
+
+    // Recursive, bounded by max_extension_depth whatever the limits.
+    feed::extension parse_extension(boost::string_ref uri,
+                                    std::size_t depth = 0) {
+        feed::extension element;
+        element.namespace_uri_ = uri.to_string();
+        decode(reader_.local_name(), true, element.name_);
+        for (const auto &attribute : reader_.attributes()) {
+            if (attribute.name == "xmlns" ||
+                attribute.name.starts_with("xmlns:"))
+                continue;
+
+            const timed scope(*this, phase::decode);
+            std::string value;
+            decode_field(attribute.value, false, value);
+            std::string name;
+            decode(attribute.name, true, name);
+            append(element.attributes_, std::move(name), std::move(value));
+        }
+
+        bool whole = true;
+        for (;;)
+            switch (next()) {
+            case xml_reader::token::text: {
+                if (!whole)
+                    break;
+
+                const timed scope(*this, phase::decode);
+                const auto capacity = element.value_.capacity();
+
+                whole = decode_field(reader_.text(), reader_.cdata(),
+                                     element.value_);
+                allocated(capacity, element.value_.capacity());
+                break;
+            }
+            case xml_reader::token::start_element: {
+                // Children of a foreign element are kept whatever their
+                // namespace, e.g. media:group holding media:content.
+                if (depth + 1 >= max_extension_depth) {
+                    if (limits_.policy == limit_policy::fail)
+                        throw std::runtime_error(
+                            "extension nested too deep");
+                    skip();
+                    break;
+                }
+
+                const auto child_uri = reader_.namespace_uri().to_string();
+                append(element.children_,
+                       parse_extension(child_uri, depth + 1));
+                break;
+            }
+            case xml_reader::token::end_element:
+            case xml_reader::token::end_document:
+                return element;
+            }
+    }
+
+    void allocated(std::size_t before, std::size_t after) {
+#ifdef FEED_PARSER_STATS
+        // Anything past the capacity of an empty string lives on the heap.
+        static const std::size_t inline_capacity = std::string().capacity();
+        if (stats_ && after != before && after > inline_capacity)
+            ++stats_->allocations;
+#else
+        (void)before;
+        (void)after;
+#endif
+    }
+
+#ifdef FEED_PARSER_STATS
+    phase enter(phase next) {
+        if (!stats_)
+            return current_;
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_);
+        switch (current_) {
+        case phase::tokenize:
+            stats_->tokenize += elapsed;
+            break;
+        case phase::dates:
+            stats_->dates += elapsed;
+            break;
+        case phase::decode:
+            stats_->decode += elapsed;
+            break;
+        case phase::build:
+            stats_->build += elapsed;
+            break;
+        }
+        last_ = now;
+
+        const auto previous = current_;
+        current_ = next;
+
+        return previous;
+    }
+
+    phase current_ = phase::build;
+    std::chrono::steady_clock::time_point last_;
+#endif
+
+    boost::string_ref document_;
+    xml_reader reader_;
+    parse_stats *stats_;
+    const extension_registry *extensions_;
+    charset charset_;
+    utf8_policy utf8_;
+    bool repair_ = false;
+    // Tokens between two checks of cancel_ and deadline_, a few microseconds
+    // of parsing.
+    static const std::size_t check_interval = 256;
+    // Levels of an extension and its children, below what serialization
+    // accepts.
+    static const std::size_t max_extension_depth = 256;
+    cancellation_token cancel_;
+    boost::optional<std::chrono::steady_clock::time_point> deadline_;
+    bool interruptible_;
+    std::size_t tokens_ = 0;
+    parse_limits limits_;
+    std::string scratch_;
+};
+
+// Sorts the items of a document into new, changed and unchanged against the
+// feed_state of a previous poll, and gathers the state of this one.
+class delta_tracker {
+  public:
+    explicit delta_tracker(const feed_state &previous) : previous_(previous) {}
+
+    // Records an item, returns whether it is unchanged and may be skipped.
+    bool unchanged(const element_hashes &hashes) {
+        entries_.emplace_back(hashes.key, hashes.content);
+
+        const auto content = previous_.find(hashes.key);
+        seen_ = static_cast<bool>(content);
+        if (!seen_ || content.value() != hashes.content)
+            return false;
+
+        ++unchanged_;
+
+        return true;
+    }
+
+    // The last item recorded has been built as the index-th of the result.
+    void built(std::size_t index) {
+        if (seen_)
+            changed_.push_back(index);
+    }
+
+    std::vector<std::size_t> &changed() { return changed_; }
+    std::size_t unchanged_count() const { return unchanged_; }
+    feed_state state() { return feed_state(std::move(entries_)); }
+
+  private:
+    const feed_state &previous_;
+    std::vector<feed_state::entry> entries_;
+    std::vector<std::size_t> changed_;
+    std::size_t unchanged_ = 0;
+    bool seen_ = false;
+};
+
+// Number conversions with the semantics of boost::property_tree's stream
+// translator: surrounding whitespace is allowed, anything else is not.
+template <typename T> boost::optional<T> to_number(const std::string &str) {
+    auto pos = str.find_first_not_of(" \t\n\r");
+    if (pos == std::string::npos)
+        return {};
+    if (str[pos] == '+')
+        ++pos;
+
+    std::uint64_t value = 0;
+    std::size_t digits = 0;
+    for (; pos < str.size() && str[pos] >= '0' && str[pos] <= '9';
+         ++pos, ++digits) {
+        const auto digit = static_cast<std::uint64_t>(str[pos] - '0');
+        if (value > (std::numeric_limits<T>::max() - digit) / 10)
+            return {};
+        value = value * 10 + digit;
+    }
+    if (digits == 0 ||
+        str.find_first_not_of(" \t\n\r", pos) != std::string::npos)
+        return {};
+
+    return static_cast<T>(value);
+}
+
+inline boost::optional<bool> to_bool(const std::string &str) {
+    const auto first = str.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos)
+        return {};
+    const auto last = str.find_last_not_of(" \t\n\r");
+    const auto value = str.substr(first, last - first + 1);
+
+    if (value == "1" || value == "true")
+        return true;
+    if (value == "0" || value == "false")
+        return false;
+
+    return {};
+}
+
+template <typename T>
+T to_number(const boost::optional<std::string> &str, const std::string &name) {
+    if (!str)
+        parse_context::missing(name);
+
+    const auto value = to_number<T>(str.value());
+    if (!value)
+        throw std::runtime_error("conversion of data failed (" + name + ")");
+
+    return value.value();
+}
+}
+}
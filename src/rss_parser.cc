@@ -26,13 +26,16 @@
 **
 ****************************************************************************/
 
-#include <boost/property_tree/xml_parser.hpp>
+#include "parse_context.h"
+#include <exception>
 #include <feed/date_time/tz.h>
+#include <feed/log.h>
 #include <feed/rss_parser.h>
-#include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <unordered_map>
 
-static std::unordered_map<std::string, std::string> offset_map = {
+static const std::unordered_map<std::string, std::string> offset_map = {
     {"GMT", "+0000"}, {"UTC", "+0000"}, {"UT", "+0000"},  {"EDT", "-0400"},
     {"EST", "-0500"}, {"CDT", "-0500"}, {"CST", "-0600"}, {"MDT", "-0600"},
     {"MST", "-0700"}, {"PDT", "-0700"}, {"PST", "-0800"}, {"A", "+0100"},
@@ -43,276 +46,512 @@ static std::unordered_map<std::string, std::string> offset_map = {
     {"S", "-0600"},   {"T", "-0700"},   {"U", "-0800"},   {"V", "-0900"},
     {"W", "-1000"},   {"X", "-1100"},   {"Y", "-1200"},   {"Z", "+0000"}};
 
-static date::second_point get_time(const std::string &str) {
-    // TODO: Error Handling
+// None if str is not an RFC 822 date with a numeric or a known zone.
+static boost::optional<date::second_point> get_time(const std::string &str) {
     const auto pos = str.find_last_of(' ');
     const std::string utc_offset = str.substr(pos + 1);
     std::string time_str = str.substr(0, pos + 1);
-    date::second_point time_point;
     if (utc_offset.size() != 5) {
-        std::istringstream time_stream(time_str + offset_map[utc_offset]);
-        date::parse(time_stream, "%a, %d %h %Y %T %z", time_point);
+        const auto offset = offset_map.find(utc_offset);
+        if (offset == offset_map.end())
+            return {};
+        time_str += offset->second;
     } else {
-        std::istringstream time_stream(str);
-        date::parse(time_stream, "%a, %d %h %Y %T %z", time_point);
+        time_str = str;
     }
 
+    std::istringstream time_stream(time_str);
+    date::second_point time_point;
+    date::parse(time_stream, "%a, %d %h %Y %T %z", time_point);
+    if (time_stream.fail())
+        return {};
+
     return time_point;
 }
 
 namespace feed {
 namespace rss {
-boost::optional<rss_data> parse_rss(const std::string &xml_str) {
-    boost::property_tree::ptree root;
-
-    std::istringstream stream(xml_str);
-
-    rss_data data;
-
-    try {
-        boost::property_tree::read_xml(stream, root);
-
-        const auto &rss_node = root.get_child("rss");
-
-        const auto &channel_node = rss_node.get_child("channel");
-
-        const auto rss_attr_node = rss_node.get_child_optional("<xmlattr>");
-        if (rss_attr_node) {
-            const auto xmlns_atom_node =
-                rss_attr_node->get_optional<std::string>("xmlns:atom");
-            if (xmlns_atom_node)
-                if (xmlns_atom_node.value() == "http://www.w3.org/2005/Atom") {
-                    const auto atom_link_node_attr =
-                        channel_node.get_child_optional("atom:link.<xmlattr>");
-                    if (atom_link_node_attr) {
-                        atom::link atom_link;
-                        atom_link.href_ =
-                            atom_link_node_attr->get<std::string>("href");
-                        atom_link.href_lang_ =
-                            atom_link_node_attr->get_optional<std::string>(
-                                "hreflang");
-                        atom_link.length_ =
-                            atom_link_node_attr->get_optional<std::uint64_t>(
-                                "length");
-                        atom_link.title_ =
-                            atom_link_node_attr->get_optional<std::string>(
-                                "title");
-                        atom_link.type_ =
-                            atom_link_node_attr->get_optional<std::string>(
-                                "type");
-
-                        const auto rel_node =
-                            atom_link_node_attr->get_child_optional("rel");
-                        if (rel_node) {
-                            const std::string ref =
-                                rel_node->get_value<std::string>();
-                            if (ref == "alternate")
-                                atom_link.rel_ = atom::rel::alternate;
-                            else if (ref == "enclosure")
-                                atom_link.rel_ = atom::rel::enclosure;
-                            else if (ref == "related")
-                                atom_link.rel_ = atom::rel::related;
-                            else if (ref == "self")
-                                atom_link.rel_ = atom::rel::self;
-                            else
-                                atom_link.rel_ = atom::rel::via;
-                        }
-
-                        data.atom_link_.emplace(std::move(atom_link));
+class parser {
+  public:
+    parser(const std::string &xml_str, const parse_options &options,
+           const std::function<bool(item &&)> *on_item = nullptr,
+           detail::delta_tracker *delta = nullptr)
+        : context_(xml_str, options), on_item_(on_item), delta_(delta) {}
+
+    boost::optional<rss_data> parse() {
+        try {
+            rss_data data = document();
+            context_.finish(false);
+
+            return std::move(data);
+        } catch (const std::exception &e) {
+            context_.finish(true);
+            if (callback_error_)
+                std::rethrow_exception(callback_error_);
+            if (log_enabled(log_level::error))
+                log(log_level::error, std::string("parse_rss: ") + e.what());
+        }
+
+        return {};
+    }
+
+  private:
+    rss_data document() {
+        rss_data data;
+        bool has_rss = false;
+        context_.begin();
+        data.valid_utf8_ = context_.valid_utf8();
+
+        for (;;) {
+            const auto token = context_.next();
+            if (token == xml_reader::token::end_document)
+                break;
+            if (token != xml_reader::token::start_element)
+                continue;
+
+            if (!has_rss && context_.reader().name() == "rss") {
+                rss(data);
+                has_rss = true;
+                if (stopped_)
+                    break;
+            } else {
+                context_.skip();
+            }
+        }
+
+        if (!has_rss)
+            detail::parse_context::missing("rss");
+
+        return data;
+    }
+
+    void rss(rss_data &data) {
+        bool has_channel = false;
+        while (!stopped_ && context_.child())
+            if (!has_channel && context_.reader().name() == "channel") {
+                channel(data);
+                has_channel = true;
+            } else {
+                context_.skip();
+            }
+
+        if (!has_channel)
+            detail::parse_context::missing("channel");
+    }
+
+    void channel(rss_data &data) {
+        const bool itunes = context_.reader().bound(xmlns::itunes);
+        bool has_title = false;
+        bool has_link = false;
+        bool has_description = false;
+        bool has_cloud = false;
+        bool has_ttl = false;
+        bool has_atom_link = false;
+        std::vector<category> categories;
+        std::vector<extension> extensions;
+        boost::optional<std::string> new_feed_url;
+
+        while (context_.child()) {
+            const auto name = context_.reader().name();
+            const auto uri = context_.reader().namespace_uri();
+
+            if (name == "item") {
+                // Before the item is recorded, one over the limit must not
+                // look known to the next poll.
+                if (!context_.more_items(items_)) {
+                    context_.skip();
+                    continue;
+                }
+                if (delta_) {
+                    const auto hashes = context_.hashes({"guid", "link"});
+                    if (delta_->unchanged(hashes)) {
+                        context_.skip_to(hashes.end);
+                        continue;
                     }
+                    delta_->built(items_);
                 }
 
-            const auto xmlns_itunes_node =
-                rss_attr_node->get_optional<std::string>("xmlns:itunes");
-            if (xmlns_itunes_node)
-                if (xmlns_itunes_node.value() ==
-                    "http://www.itunes.com/dtds/podcast-1.0.dtd") {
-                    itunes::channel_level::itunes_extensions itunes;
-                    ;
-                    itunes.new_feed_url_ =
-                        channel_node.get_optional<std::string>(
-                            "itunes:new-feed-url");
-
-                    data.itunes_.emplace(std::move(itunes));
+                if (!on_item_) {
+                    context_.append(data.items_, parse_item());
+                } else if (!hand_over(parse_item())) {
+                    stopped_ = true;
+                    break;
                 }
+                context_.item();
+                ++items_;
+            } else if (name == "category") {
+                context_.append(categories, parse_category());
+            } else if (name == "title" && !has_title) {
+                data.title_ = context_.text();
+                has_title = true;
+            } else if (name == "link" && !has_link) {
+                data.link_ = context_.text();
+                has_link = true;
+            } else if (name == "description" && !has_description) {
+                data.description_ = context_.text();
+                has_description = true;
+            } else if (name == "language" && !data.language_) {
+                data.language_ = context_.text();
+            } else if (name == "copyright" && !data.copyright_) {
+                data.copyright_ = context_.text();
+            } else if (name == "managingEditor" && !data.managing_editor_) {
+                data.managing_editor_ = context_.text();
+            } else if (name == "webMaster" && !data.web_master_) {
+                data.web_master_ = context_.text();
+            } else if (name == "pubDate" && !data.pub_date_) {
+                data.pub_date_ = context_.date(get_time, context_.text());
+            } else if (name == "lastBuildDate" && !data.last_build_date_) {
+                data.last_build_date_ =
+                    context_.date(get_time, context_.text());
+            } else if (name == "generator" && !data.generator_) {
+                data.generator_ = context_.text();
+            } else if (name == "docs" && !data.docs_) {
+                data.docs_ = context_.text();
+            } else if (name == "cloud" && !has_cloud) {
+                if (!context_.reader().attributes().empty())
+                    data.cloud_.emplace(parse_cloud());
+                context_.skip();
+                has_cloud = true;
+            } else if (name == "ttl" && !has_ttl) {
+                data.ttl_ = detail::to_number<std::uint16_t>(context_.text());
+                has_ttl = true;
+            } else if (name == "image" && !data.image_) {
+                data.image_.emplace(parse_image());
+            } else if (name == "textInput" && !data.text_input_) {
+                data.text_input_.emplace(parse_text_input());
+            } else if (name == "skipHours" && !data.skip_hours_) {
+                std::vector<std::uint16_t> skip_hours;
+
+                while (context_.child())
+                    context_.append(skip_hours,
+                                    detail::to_number<std::uint16_t>(
+                                        context_.text(), "skipHours"));
+
+                data.skip_hours_.emplace(std::move(skip_hours));
+            } else if (name == "skipDays" && !data.skip_days_) {
+                std::vector<day> skip_days;
+
+                while (context_.child())
+                    context_.append(skip_days, parse_day(context_.text()));
+
+                data.skip_days_.emplace(std::move(skip_days));
+            } else if (uri == xmlns::atom &&
+                       context_.reader().local_name() == "link" &&
+                       !has_atom_link) {
+                if (!context_.reader().attributes().empty())
+                    data.atom_link_.emplace(parse_atom_link());
+                context_.skip();
+                has_atom_link = true;
+            } else if (uri == xmlns::itunes &&
+                       context_.reader().local_name() == "new-feed-url" &&
+                       !new_feed_url) {
+                new_feed_url = context_.text();
+            } else if (!context_.extension(extensions)) {
+                context_.skip();
+            }
         }
 
-        data.title_ = channel_node.get<std::string>("title");
-        data.link_ = channel_node.get<std::string>("link");
-        data.description_ = channel_node.get<std::string>("description");
-        data.language_ = channel_node.get_optional<std::string>("language");
-        data.copyright_ = channel_node.get_optional<std::string>("copyright");
-        data.managing_editor_ =
-            channel_node.get_optional<std::string>("managingEditor");
-        data.web_master_ = channel_node.get_optional<std::string>("webMaster");
-
-        const auto pub_date = channel_node.get_optional<std::string>("pubDate");
-        if (pub_date)
-            data.pub_date_ = get_time(pub_date.value());
-
-        const auto last_build_date =
-            channel_node.get_optional<std::string>("lastBuildDate");
-        if (last_build_date)
-            data.last_build_date_ = get_time(last_build_date.value());
-
-        data.generator_ = channel_node.get_optional<std::string>("generator");
-        data.docs_ = channel_node.get_optional<std::string>("docs");
-
-        const auto cloud_attr_node =
-            channel_node.get_child_optional("cloud.<xmlattr>");
-        if (cloud_attr_node) {
-            cloud cloud;
-            cloud.domain_ = cloud_attr_node->get<std::string>("domain");
-            cloud.path_ = cloud_attr_node->get<std::string>("path");
-            cloud.port_ = cloud_attr_node->get<std::uint16_t>("port");
-            cloud.protocol_ =
-                (cloud_attr_node->get<std::string>("protocol") == "xml-rpc")
-                    ? protocol::xml_rpc
-                    : protocol::soap;
-            cloud.register_procedure_ =
-                cloud_attr_node->get<std::string>("register_procedure");
-
-            data.cloud_.emplace(std::move(cloud));
-        }
+        // A stopped parse has not seen the rest of the channel.
+        if (!has_title && !stopped_)
+            detail::parse_context::missing("title");
+        if (!has_link && !stopped_)
+            detail::parse_context::missing("link");
+        if (!has_description && !stopped_)
+            detail::parse_context::missing("description");
 
-        data.ttl_ = channel_node.get_optional<std::uint16_t>("ttl");
+        if (!categories.empty())
+            data.categories_.emplace(std::move(categories));
+        if (!extensions.empty())
+            data.extensions_.emplace(std::move(extensions));
 
-        const auto image_node = channel_node.get_child_optional("image");
-        if (image_node) {
-            image image;
-            image.url_ = image_node->get<std::string>("url");
-            image.title_ = image_node->get<std::string>("title");
-            image.link_ = image_node->get<std::string>("link");
-            image.width_ = image_node->get_optional<std::uint16_t>("width");
-            image.height_ = image_node->get_optional<std::uint16_t>("height");
-            image.description_ =
-                image_node->get_optional<std::string>("description");
+        if (itunes) {
+            itunes::channel_level::itunes_extensions extensions;
+            extensions.new_feed_url_ = std::move(new_feed_url);
 
-            data.image_.emplace(std::move(image));
+            data.itunes_.emplace(std::move(extensions));
         }
+    }
 
-        const auto text_input_node =
-            channel_node.get_child_optional("textInput");
-        if (text_input_node) {
-            text_input input;
-            input.title_ = text_input_node->get<std::string>("title");
-            input.description_ =
-                text_input_node->get<std::string>("description");
-            input.name_ = text_input_node->get<std::string>("name");
-            input.link_ = text_input_node->get<std::string>("link");
-
-            data.text_input_.emplace(std::move(input));
+    item parse_item() {
+        item item;
+        bool has_enclosure = false;
+        std::vector<category> categories;
+        std::vector<extension> extensions;
+
+        while (context_.child()) {
+            const auto name = context_.reader().name();
+
+            if (name == "title" && !item.title_) {
+                item.title_ = context_.text();
+            } else if (name == "link" && !item.link_) {
+                item.link_ = context_.text();
+            } else if (name == "description" && !item.description_) {
+                item.description_ = context_.text();
+            } else if (name == "author" && !item.author_) {
+                item.author_ = context_.text();
+            } else if (name == "category") {
+                context_.append(categories, parse_category());
+            } else if (name == "comments" && !item.comments_) {
+                item.comments_ = context_.text();
+            } else if (name == "enclosure" && !has_enclosure) {
+                if (context_.reader().attributes().empty())
+                    detail::parse_context::missing("enclosure.<xmlattr>");
+
+                auto url = context_.required_attribute("url");
+                auto length = context_.attribute("length");
+                auto type = context_.required_attribute("type");
+                item.enclosure_.emplace(
+                    std::move(url),
+                    length ? detail::to_number<std::uint64_t>(length.value())
+                           : boost::none,
+                    std::move(type));
+                context_.skip();
+                has_enclosure = true;
+            } else if (name == "guid" && !item.guid_) {
+                const auto is_perma_link = context_.attribute("isPermaLink");
+                item.guid_.emplace(context_.text(),
+                                   is_perma_link
+                                       ? detail::to_bool(is_perma_link.value())
+                                       : boost::none);
+            } else if (name == "pubDate" && !item.pub_date_) {
+                item.pub_date_ = context_.date(get_time, context_.text());
+            } else if (name == "source" && !item.source_) {
+                auto url = context_.required_attribute("url");
+                item.source_.emplace(context_.text(), std::move(url));
+            } else if (!context_.extension(extensions)) {
+                context_.skip();
+            }
         }
 
-        const auto skip_hours_node =
-            channel_node.get_child_optional("skipHours");
-        if (skip_hours_node) {
-            std::vector<std::uint16_t> skip_hours;
+        if (!has_enclosure)
+            detail::parse_context::missing("enclosure");
+
+        if (!categories.empty())
+            item.categories_.emplace(std::move(categories));
+        if (!extensions.empty())
+            item.extensions_.emplace(std::move(extensions));
+
+        return item;
+    }
+
+    category parse_category() {
+        auto domain = context_.attribute("domain");
 
-            for (const auto &hour : skip_hours_node.value())
-                skip_hours.emplace_back(hour.second.get_value<std::uint16_t>());
+        return {context_.text(), std::move(domain)};
+    }
+
+    cloud parse_cloud() {
+        cloud cloud;
+        cloud.domain_ = context_.required_attribute("domain");
+        cloud.path_ = context_.required_attribute("path");
+        cloud.port_ = detail::to_number<std::uint16_t>(
+            context_.attribute("port"), "<xmlattr>.port");
+        cloud.protocol_ = (context_.required_attribute("protocol") == "xml-rpc")
+                              ? protocol::xml_rpc
+                              : protocol::soap;
+        cloud.register_procedure_ =
+            context_.required_attribute("register_procedure");
+
+        return cloud;
+    }
 
-            data.skip_hours_.emplace(std::move(skip_hours));
+    image parse_image() {
+        image image;
+        bool has_url = false;
+        bool has_title = false;
+        bool has_link = false;
+        bool has_width = false;
+        bool has_height = false;
+
+        while (context_.child()) {
+            const auto name = context_.reader().name();
+
+            if (name == "url" && !has_url) {
+                image.url_ = context_.text();
+                has_url = true;
+            } else if (name == "title" && !has_title) {
+                image.title_ = context_.text();
+                has_title = true;
+            } else if (name == "link" && !has_link) {
+                image.link_ = context_.text();
+                has_link = true;
+            } else if (name == "width" && !has_width) {
+                image.width_ =
+                    detail::to_number<std::uint16_t>(context_.text());
+                has_width = true;
+            } else if (name == "height" && !has_height) {
+                image.height_ =
+                    detail::to_number<std::uint16_t>(context_.text());
+                has_height = true;
+            } else if (name == "description" && !image.description_) {
+                image.description_ = context_.text();
+            } else {
+                context_.skip();
+            }
         }
 
-        const auto skip_days_node = channel_node.get_child_optional("skipDays");
-        if (skip_days_node) {
-            std::vector<day> skip_days;
-
-            for (const auto &day_node : skip_days_node.value()) {
-                const std::string day =
-                    day_node.second.get_value<std::string>();
-                if (day == "Monday")
-                    skip_days.emplace_back(day::monday);
-                else if (day == "Tuesday")
-                    skip_days.emplace_back(day::tuesday);
-                else if (day == "Wednesday")
-                    skip_days.emplace_back(day::wednesday);
-                else if (day == "Thursday")
-                    skip_days.emplace_back(day::thursday);
-                else if (day == "Friday")
-                    skip_days.emplace_back(day::friday);
-                else if (day == "Saturday")
-                    skip_days.emplace_back(day::saturday);
-                else
-                    skip_days.emplace_back(day::sunday);
+        if (!has_url)
+            detail::parse_context::missing("url");
+        if (!has_title)
+            detail::parse_context::missing("title");
+        if (!has_link)
+            detail::parse_context::missing("link");
+
+        return image;
+    }
+
+    text_input parse_text_input() {
+        text_input input;
+        bool has_title = false;
+        bool has_description = false;
+        bool has_name = false;
+        bool has_link = false;
+
+        while (context_.child()) {
+            const auto name = context_.reader().name();
+
+            if (name == "title" && !has_title) {
+                input.title_ = context_.text();
+                has_title = true;
+            } else if (name == "description" && !has_description) {
+                input.description_ = context_.text();
+                has_description = true;
+            } else if (name == "name" && !has_name) {
+                input.name_ = context_.text();
+                has_name = true;
+            } else if (name == "link" && !has_link) {
+                input.link_ = context_.text();
+                has_link = true;
+            } else {
+                context_.skip();
             }
+        }
+
+        if (!has_title)
+            detail::parse_context::missing("title");
+        if (!has_description)
+            detail::parse_context::missing("description");
+        if (!has_name)
+            detail::parse_context::missing("name");
+        if (!has_link)
+            detail::parse_context::missing("link");
 
-            data.skip_days_.emplace(std::move(skip_days));
+        return input;
+    }
+
+    static day parse_day(const std::string &str) {
+        if (str == "Monday")
+            return day::monday;
+        else if (str == "Tuesday")
+            return day::tuesday;
+        else if (str == "Wednesday")
+            return day::wednesday;
+        else if (str == "Thursday")
+            return day::thursday;
+        else if (str == "Friday")
+            return day::friday;
+        else if (str == "Saturday")
+            return day::saturday;
+        else
+            return day::sunday;
+    }
+
+    atom::link parse_atom_link() {
+        atom::link atom_link;
+        atom_link.href_ = context_.required_attribute("href");
+        atom_link.href_lang_ = context_.attribute("hreflang");
+        const auto length = context_.attribute("length");
+        if (length)
+            atom_link.length_ =
+                detail::to_number<std::uint64_t>(length.value());
+        atom_link.title_ = context_.attribute("title");
+        atom_link.type_ = context_.attribute("type");
+
+        const auto rel_attr = context_.attribute("rel");
+        if (rel_attr) {
+            const std::string &ref = rel_attr.value();
+            if (ref == "alternate")
+                atom_link.rel_ = atom::rel::alternate;
+            else if (ref == "enclosure")
+                atom_link.rel_ = atom::rel::enclosure;
+            else if (ref == "related")
+                atom_link.rel_ = atom::rel::related;
+            else if (ref == "self")
+                atom_link.rel_ = atom::rel::self;
+            else
+                atom_link.rel_ = atom::rel::via;
         }
 
-        std::vector<category> categories;
+        return atom_link;
+    }
 
-        for (const auto &channel_child : channel_node)
-            if (channel_child.first == "item") {
-                const auto &item_node = channel_child.second;
-
-                item item;
-                item.title_ = item_node.get_optional<std::string>("title");
-                item.link_ = item_node.get_optional<std::string>("link");
-                item.description_ =
-                    item_node.get_optional<std::string>("description");
-                item.author_ = item_node.get_optional<std::string>("author");
-
-                std::vector<category> categories;
-
-                for (const auto &item_child : item_node)
-                    if (item_child.first == "category") {
-                        const auto &category_node = item_child.second;
-                        categories.emplace_back(
-                            category_node.get_value<std::string>(),
-                            category_node.get_optional<std::string>(
-                                "<xmlattr>.domain"));
-                    }
+    // Exceptions of on_item_ end the parse like parse errors, then parse()
+    // rethrows them instead of logging.
+    bool hand_over(item &&built) {
+        try {
+            return (*on_item_)(std::move(built));
+        } catch (...) {
+            callback_error_ = std::current_exception();
+            throw std::runtime_error("item callback failed");
+        }
+    }
 
-                if (!categories.empty())
-                    item.categories_.emplace(std::move(categories));
+    detail::parse_context context_;
+    // Set for parse_rss() with callbacks, items are handed to it instead of
+    // being kept.
+    const std::function<bool(item &&)> *on_item_;
+    std::size_t items_ = 0;
+    bool stopped_ = false; // By on_item_.
+    std::exception_ptr callback_error_; // Thrown by on_item_, for parse().
+    // Set for parse_rss() with a feed_state, unchanged items are skipped.
+    detail::delta_tracker *delta_;
+};
 
-                item.comments_ =
-                    item_node.get_optional<std::string>("comments");
+boost::optional<rss_data> parse_rss(const std::string &xml_str) {
+    return parser(xml_str, parse_options()).parse();
+}
 
-                const auto &enclosure_attr_node =
-                    item_node.get_child("enclosure.<xmlattr>");
-                item.enclosure_.emplace(
-                    enclosure_attr_node.get<std::string>("url"),
-                    enclosure_attr_node.get_optional<std::uint64_t>("length"),
-                    enclosure_attr_node.get<std::string>("type"));
-
-                const auto guid_node = item_node.get_child_optional("guid");
-                if (guid_node)
-                    item.guid_.emplace(
-                        guid_node->get_value<std::string>(),
-                        guid_node->get_optional<bool>("<xmlattr>.isPermaLink"));
-
-                const auto pub_date =
-                    item_node.get_optional<std::string>("pubDate");
-                if (pub_date)
-                    item.pub_date_ = get_time(pub_date.value());
-
-                const auto source_node = item_node.get_child_optional("source");
-                if (source_node)
-                    item.source_.emplace(
-                        source_node->get_value<std::string>(),
-                        source_node->get<std::string>("<xmlattr>.url"));
-
-                data.items_.emplace_back(std::move(item));
-            } else if (channel_child.first == "category") {
-                const auto &category_node = channel_child.second;
-
-                categories.emplace_back(category_node.get_value<std::string>(),
-                                        category_node.get_optional<std::string>(
-                                            "<xmlattr>.domain"));
-            }
+boost::optional<rss_data> parse_rss(const std::string &xml_str,
+                                    parse_stats &stats) {
+    parse_options options;
+    options.stats = &stats;
 
-        if (!categories.empty())
-            data.categories_.emplace(std::move(categories));
+    return parser(xml_str, options).parse();
+}
 
-        return std::move(data);
-    } catch (const std::exception &e) {
-        std::cerr << "Error: " << e.what() << std::endl;
-    }
+boost::optional<rss_data> parse_rss(const std::string &xml_str,
+                                    const parse_options &options) {
+    return parser(xml_str, options).parse();
+}
+
+boost::optional<rss_delta> parse_rss(const std::string &xml_str,
+                                     const feed_state &previous,
+                                     const parse_options &options) {
+    detail::delta_tracker delta(previous);
+    auto data = parser(xml_str, options, nullptr, &delta).parse();
+    if (!data)
+        return {};
+
+    rss_delta result(std::move(data.value()));
+    result.changed = std::move(delta.changed());
+    result.unchanged = delta.unchanged_count();
+    result.state = delta.state();
+
+    return std::move(result);
+}
+
+bool parse_rss(const std::string &xml_str,
+               const std::function<void(rss_data &&)> &on_channel,
+               const std::function<bool(item &&)> &on_item,
+               const parse_options &options) {
+    auto data = parser(xml_str, options, &on_item).parse();
+    if (!data)
+        return false;
+
+    if (on_channel)
+        on_channel(std::move(data.value()));
 
-    return {};
+    return true;
 }
 }
 }
@@ -0,0 +1,247 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <feed/log.h>
+#include <feed/scheduler.h>
+
+using clock_type = feed::scheduler::clock;
+
+// Whether a feed asks not to be polled during the hour at time.
+static bool skipped(clock_type::time_point time, const feed::poll_hints &hints) {
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch())
+            .count();
+    auto days = seconds / 86400;
+    if (seconds % 86400 < 0)
+        --days;
+    const auto hour = static_cast<std::uint16_t>((seconds - days * 86400) / 3600);
+    // The epoch was a Thursday.
+    const auto weekday =
+        static_cast<feed::rss::day>(((days + 3) % 7 + 7) % 7);
+
+    return std::find(hints.skip_hours.begin(), hints.skip_hours.end(), hour) !=
+               hints.skip_hours.end() ||
+           std::find(hints.skip_days.begin(), hints.skip_days.end(),
+                     weekday) != hints.skip_days.end();
+}
+
+namespace feed {
+poll_hints poll_hints::from(const rss::rss_data &feed) {
+    poll_hints hints;
+    if (feed.ttl())
+        hints.ttl = std::chrono::minutes(feed.ttl().value());
+    if (feed.skip_hours())
+        hints.skip_hours = feed.skip_hours().value();
+    if (feed.skip_days())
+        hints.skip_days = feed.skip_days().value();
+
+    return hints;
+}
+
+scheduler::scheduler(scheduler_config config)
+    : config_(std::move(config)), random_(config_.seed) {}
+
+void scheduler::add(const std::string &uri, clock::time_point due) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::uint32_t id;
+    const auto it = ids_.find(uri);
+    if (it != ids_.end()) {
+        id = it->second;
+    } else {
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+        } else {
+            id = static_cast<std::uint32_t>(entries_.size());
+            entries_.emplace_back();
+        }
+        entries_[id].uri = uri;
+        ids_.emplace(uri, id);
+    }
+
+    schedule(id, due);
+}
+
+bool scheduler::remove(const std::string &uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = ids_.find(uri);
+    if (it == ids_.end())
+        return false;
+
+    auto &entry = entries_[it->second];
+    ++entry.generation;
+    entry.scheduled = false;
+    std::string().swap(entry.uri);
+    free_.push_back(it->second);
+    ids_.erase(it);
+    drop_stale();
+
+    return true;
+}
+
+scheduler::clock::time_point scheduler::polled(const std::string &uri,
+                                               const poll_hints &hints,
+                                               clock::time_point at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto next = at + interval(hints);
+    if (!hints.skip_hours.empty() || !hints.skip_days.empty()) {
+        // Moves to the start of the next hour until one is not skipped, a
+        // week at most since skipping every hour makes no sense.
+        auto candidate = next;
+        for (int hours = 0; hours <= 24 * 7 && skipped(candidate, hints);
+             ++hours)
+            candidate = std::chrono::time_point_cast<std::chrono::hours>(
+                            candidate) +
+                        std::chrono::hours(1);
+        if (!skipped(candidate, hints))
+            next = candidate;
+    }
+
+    const auto it = ids_.find(uri);
+    if (it != ids_.end())
+        schedule(it->second, next);
+
+    return next;
+}
+
+std::vector<std::string> scheduler::due(clock::time_point now,
+                                        std::size_t max) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::string> uris;
+    while (uris.size() < max && !heap_.empty() && heap_.front().due <= now) {
+        auto &entry = entries_[heap_.front().id];
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<slot>());
+        heap_.pop_back();
+
+        entry.scheduled = false;
+        uris.push_back(entry.uri);
+        drop_stale();
+    }
+
+    return uris;
+}
+
+std::size_t scheduler::dispatch(
+    fetcher &fetcher,
+    std::function<void(const std::string &uri, const fetch_result &result)>
+        handler,
+    clock::time_point now) {
+    const auto uris = due(now);
+    for (const auto &uri : uris)
+        fetcher.fetch_async(uri).then(
+            [uri, handler](pplx::task<fetch_result> fetched) {
+                // Nobody waits on this task, an escaping exception would go
+                // unobserved, whether the fetch or the handler threw it.
+                try {
+                    handler(uri, fetched.get());
+                } catch (const std::exception &e) {
+                    if (log_enabled(log_level::error))
+                        log(log_level::error, uri + ": " + e.what());
+                } catch (...) {
+                    if (log_enabled(log_level::error))
+                        log(log_level::error, uri + ": unknown exception");
+                }
+            });
+
+    return uris.size();
+}
+
+boost::optional<scheduler::clock::time_point> scheduler::next_due() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (heap_.empty())
+        return {};
+
+    return heap_.front().due;
+}
+
+std::size_t scheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return ids_.size();
+}
+
+void scheduler::schedule(std::uint32_t id, clock::time_point due) {
+    auto &entry = entries_[id];
+    ++entry.generation;
+    entry.scheduled = true;
+    heap_.push_back(slot{due, id, entry.generation});
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<slot>());
+
+    // Rescheduling a scheduled feed leaves its old slot behind, rebuild the
+    // heap once those are as many as the live ones.
+    if (heap_.size() > 2 * ids_.size() + 64) {
+        heap_.erase(std::remove_if(heap_.begin(), heap_.end(),
+                                   [this](const slot &slot) {
+                                       return stale(slot);
+                                   }),
+                    heap_.end());
+        std::make_heap(heap_.begin(), heap_.end(), std::greater<slot>());
+    }
+
+    drop_stale();
+}
+
+bool scheduler::stale(const slot &slot) const {
+    const auto &entry = entries_[slot.id];
+
+    return !entry.scheduled || entry.generation != slot.generation;
+}
+
+void scheduler::drop_stale() {
+    while (!heap_.empty() && stale(heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<slot>());
+        heap_.pop_back();
+    }
+}
+
+scheduler::clock::duration scheduler::interval(const poll_hints &hints) {
+    clock::duration interval = config_.default_interval;
+    if (hints.estimate)
+        interval = hints.estimate.value();
+    else if (hints.ttl)
+        interval = hints.ttl.value();
+
+    // Jittered first, so that the bounds hold.
+    if (config_.jitter > 0) {
+        std::uniform_real_distribution<double> spread(-config_.jitter,
+                                                      config_.jitter);
+        interval += std::chrono::duration_cast<clock::duration>(
+            interval * spread(random_));
+    }
+
+    return std::min<clock::duration>(
+        std::max<clock::duration>(interval, config_.min_interval),
+        config_.max_interval);
+}
+}
@@ -0,0 +1,283 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <feed/hash.h>
+#include <feed/log.h>
+#include <feed/seen_filter.h>
+#include <istream>
+#include <new>
+#include <ostream>
+#include <vector>
+
+namespace feed {
+// The byte order mark is written as this machine stores it, and so are the
+// words.
+static const char magic[4] = {'F', 'P', 'B', 'F'};
+static const std::uint32_t version = 2;
+static const std::uint64_t byte_order = 0x0102030405060708ULL;
+// Words copied per write or read.
+static const std::size_t chunk_words = 8192;
+
+static std::uint64_t mix(std::uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+
+    return value ^ (value >> 31);
+}
+
+static void write(std::ostream &out, std::uint64_t value, int bytes) {
+    char buffer[8];
+    for (int i = 0; i < bytes; ++i)
+        buffer[i] = static_cast<char>(value >> (8 * i));
+    out.write(buffer, bytes);
+}
+
+static std::uint64_t swap(std::uint64_t value) {
+    value = ((value & 0x00FF00FF00FF00FFULL) << 8) |
+            ((value >> 8) & 0x00FF00FF00FF00FFULL);
+    value = ((value & 0x0000FFFF0000FFFFULL) << 16) |
+            ((value >> 16) & 0x0000FFFF0000FFFFULL);
+
+    return (value << 32) | (value >> 32);
+}
+
+static bool little_endian() {
+    const std::uint64_t one = 1;
+    char first;
+    std::memcpy(&first, &one, 1);
+
+    return first == 1;
+}
+
+static bool read(std::istream &in, std::uint64_t &value, int bytes) {
+    unsigned char buffer[8];
+    if (!in.read(reinterpret_cast<char *>(buffer), bytes))
+        return false;
+
+    value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value |= static_cast<std::uint64_t>(buffer[i]) << (8 * i);
+
+    return true;
+}
+
+seen_filter::seen_filter(layout sized)
+    : blocks_(sized.blocks), hashes_(sized.hashes),
+      words_(new std::atomic<std::uint64_t>[blocks_ * block_words]()),
+      size_(0) {}
+
+seen_filter::seen_filter(std::uint64_t capacity, double false_positive_rate)
+    : seen_filter(size_for(capacity, false_positive_rate)) {}
+
+seen_filter::layout seen_filter::size_for(std::uint64_t capacity,
+                                          double false_positive_rate) {
+    const double ln2 = std::log(2.0);
+    const double items =
+        static_cast<double>(std::max<std::uint64_t>(capacity, 1));
+    const double rate = std::min(std::max(false_positive_rate, 1e-9), 0.5);
+    // The optimum of a classic filter, blocking costs false positives and a
+    // tenth more bits makes up for it.
+    const double bits_per_item = -std::log(rate) / (ln2 * ln2);
+
+    layout sized;
+    sized.blocks = std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(std::ceil(1.1 * bits_per_item * items /
+                                             (block_bytes * 8))),
+        1);
+    sized.hashes = static_cast<std::uint32_t>(std::min<long>(
+        std::max<long>(std::lround(bits_per_item * ln2), 1), 24));
+
+    return sized;
+}
+
+seen_filter::seen_filter(seen_filter &&other) noexcept
+    : blocks_(other.blocks_), hashes_(other.hashes_),
+      words_(std::move(other.words_)),
+      size_(other.size_.load(std::memory_order_relaxed)) {}
+
+seen_filter &seen_filter::operator=(seen_filter &&other) noexcept {
+    if (&other != this) {
+        blocks_ = other.blocks_;
+        hashes_ = other.hashes_;
+        words_ = std::move(other.words_);
+        size_.store(other.size_.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    }
+
+    return *this;
+}
+
+template <typename Function>
+bool seen_filter::each_bit(std::uint64_t hash, Function found) const {
+    auto *const block = &words_[(hash % blocks_) * block_words];
+
+    // Seven positions of nine bits per 64-bit draw.
+    std::uint64_t bits = 0;
+    for (std::uint32_t i = 0; i < hashes_; ++i) {
+        if (i % 7 == 0) {
+            hash = mix(hash);
+            bits = hash;
+        }
+
+        const auto position = bits & (block_bytes * 8 - 1);
+        bits >>= 9;
+        if (!found(block[position / 64], std::uint64_t(1) << (position % 64)))
+            return false;
+    }
+
+    return true;
+}
+
+bool seen_filter::contains(boost::string_ref identity) const {
+    if (identity.empty())
+        return false;
+
+    return each_bit(hash64(identity),
+                    [](const std::atomic<std::uint64_t> &word,
+                       std::uint64_t mask) {
+                        return (word.load(std::memory_order_relaxed) &
+                                mask) != 0;
+                    });
+}
+
+bool seen_filter::contains(boost::string_ref identity,
+                           const confirm &exact) const {
+    return contains(identity) && (!exact || exact(identity));
+}
+
+bool seen_filter::insert(boost::string_ref identity) {
+    if (identity.empty())
+        return false;
+
+    bool present = true;
+    each_bit(hash64(identity), [&present](std::atomic<std::uint64_t> &word,
+                                          std::uint64_t mask) {
+        if ((word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0)
+            present = false;
+
+        return true;
+    });
+    if (!present)
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+    return present;
+}
+
+void seen_filter::save(std::ostream &out) const {
+    out.write(magic, sizeof(magic));
+    write(out, version, 4);
+    out.write(reinterpret_cast<const char *>(&byte_order), 8);
+    write(out, hashes_, 4);
+    write(out, blocks_, 8);
+    write(out, size(), 8);
+
+    const auto words = blocks_ * block_words;
+    std::vector<std::uint64_t> chunk(
+        static_cast<std::size_t>(std::min<std::uint64_t>(words, chunk_words)));
+    for (std::uint64_t i = 0; i < words; i += chunk.size()) {
+        const auto count = static_cast<std::size_t>(
+            std::min<std::uint64_t>(words - i, chunk.size()));
+        for (std::size_t j = 0; j < count; ++j)
+            chunk[j] = words_[i + j].load(std::memory_order_relaxed);
+        out.write(reinterpret_cast<const char *>(chunk.data()),
+                  static_cast<std::streamsize>(count * 8));
+    }
+}
+
+boost::optional<seen_filter> seen_filter::load(std::istream &in) {
+    char header[sizeof(magic)];
+    std::uint64_t format = 0;
+    // Version 1 has no mark, its words are little-endian.
+    std::uint64_t order = little_endian() ? byte_order : swap(byte_order);
+    std::uint64_t hashes = 0;
+    std::uint64_t blocks = 0;
+    std::uint64_t size = 0;
+    if (!in.read(header, sizeof(header)) ||
+        !std::equal(header, header + sizeof(header), magic) ||
+        !read(in, format, 4) || format == 0 || format > version ||
+        (format > 1 && !in.read(reinterpret_cast<char *>(&order), 8)) ||
+        (order != byte_order && order != swap(byte_order)) ||
+        !read(in, hashes, 4) || !read(in, blocks, 8) || !read(in, size, 8) ||
+        hashes == 0 || hashes > 64 || blocks == 0 ||
+        blocks > (std::uint64_t(1) << 40)) {
+        log(log_level::error, "seen_filter: not a filter image");
+
+        return {};
+    }
+
+    // The words must be there before they are allocated, a header alone
+    // could ask for terabytes.
+    const auto words = blocks * block_words;
+    const auto at = in.tellg();
+    if (at != std::istream::pos_type(-1)) {
+        in.seekg(0, std::ios::end);
+        const auto end = in.tellg();
+        in.seekg(at);
+        if (end == std::istream::pos_type(-1) || !in ||
+            static_cast<std::uint64_t>(end - at) / 8 < words) {
+            log(log_level::error, "seen_filter: truncated image");
+
+            return {};
+        }
+    }
+
+    layout stored;
+    stored.blocks = blocks;
+    stored.hashes = static_cast<std::uint32_t>(hashes);
+    try {
+        seen_filter filter(stored);
+        std::vector<std::uint64_t> chunk(static_cast<std::size_t>(
+            std::min<std::uint64_t>(words, chunk_words)));
+        for (std::uint64_t i = 0; i < words; i += chunk.size()) {
+            const auto count = static_cast<std::size_t>(
+                std::min<std::uint64_t>(words - i, chunk.size()));
+            if (!in.read(reinterpret_cast<char *>(chunk.data()),
+                         static_cast<std::streamsize>(count * 8))) {
+                log(log_level::error, "seen_filter: truncated image");
+
+                return {};
+            }
+            for (std::size_t j = 0; j < count; ++j)
+                filter.words_[i + j].store(
+                    order == byte_order ? chunk[j] : swap(chunk[j]),
+                    std::memory_order_relaxed);
+        }
+        filter.size_.store(size, std::memory_order_relaxed);
+
+        return std::move(filter);
+    } catch (const std::bad_alloc &) {
+        log(log_level::error, "seen_filter: image too large");
+
+        return {};
+    }
+}
+}
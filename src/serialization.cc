@@ -0,0 +1,735 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <feed/log.h>
+#include <feed/serialization.h>
+#include <stdexcept>
+
+namespace feed {
+namespace {
+using seconds = std::chrono::time_point<std::chrono::system_clock,
+                                        std::chrono::seconds>;
+
+const char magic[4] = {'F', 'P', 'S', 'F'};
+const std::uint8_t version = 1;
+// Bound on the nesting of extension elements in an image.
+const std::size_t max_extension_depth = 1024;
+enum class kind : std::uint8_t { rss, atom };
+
+class writer {
+  public:
+    explicit writer(std::string &out) : out_(out) {}
+
+    void varint(std::uint64_t value) {
+        for (; value >= 0x80; value >>= 7)
+            out_ += static_cast<char>(value | 0x80);
+        out_ += static_cast<char>(value);
+    }
+    void string(const std::string &value) {
+        varint(value.size());
+        out_.append(value);
+    }
+    void bytes(const char *data, std::size_t size) { out_.append(data, size); }
+
+  private:
+    std::string &out_;
+};
+
+class reader {
+  public:
+    explicit reader(boost::string_ref data)
+        : pos_(data.data()), end_(data.data() + data.size()) {}
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos_ == end_)
+                throw std::runtime_error("truncated image");
+
+            const auto byte = static_cast<unsigned char>(*pos_++);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+
+        throw std::runtime_error("malformed integer");
+    }
+    // A varint no greater than max.
+    std::uint64_t varint(std::uint64_t max) {
+        const auto value = varint();
+        if (value > max)
+            throw std::runtime_error("value out of range");
+
+        return value;
+    }
+    // A number of elements, each taking a byte at least, so that a corrupt
+    // one cannot reserve much more than the image.
+    std::size_t count() {
+        const auto value = varint();
+        if (value > remaining())
+            throw std::runtime_error("truncated image");
+
+        return static_cast<std::size_t>(value);
+    }
+    std::string string() {
+        const auto size = count();
+        std::string value(pos_, size);
+        pos_ += size;
+
+        return value;
+    }
+    bool bytes(const char *expected, std::size_t size) {
+        if (remaining() < size ||
+            !std::equal(expected, expected + size, pos_))
+            return false;
+        pos_ += size;
+
+        return true;
+    }
+    std::size_t remaining() const {
+        return static_cast<std::size_t>(end_ - pos_);
+    }
+
+  private:
+    const char *pos_;
+    const char *const end_;
+};
+
+// The presence bitmask of an object, bit i for its i-th optional member or
+// flag.
+class presence {
+  public:
+    presence() {}
+    explicit presence(std::uint64_t mask) : mask_(mask) {}
+
+    presence &operator<<(bool set) {
+        if (set)
+            mask_ |= std::uint64_t(1) << bit_;
+        ++bit_;
+
+        return *this;
+    }
+    template <typename T>
+    presence &operator<<(const boost::optional<T> &value) {
+        return *this << static_cast<bool>(value);
+    }
+
+    // Whether the next member is present.
+    bool next() { return (mask_ >> bit_++ & 1) != 0; }
+    std::uint64_t mask() const { return mask_; }
+
+  private:
+    std::uint64_t mask_ = 0;
+    unsigned bit_ = 0;
+};
+
+template <typename T> struct tag {};
+}
+
+namespace detail {
+// Writes and reads the members of the model, whose classes befriend it.
+// Members are in declaration order, optional ones only if present.
+class codec {
+  public:
+    static void write(writer &out, const std::string &value) {
+        out.string(value);
+    }
+    static void write(writer &out, std::uint16_t value) { out.varint(value); }
+    static void write(writer &out, std::uint64_t value) { out.varint(value); }
+    static void write(writer &out, const seconds &value) {
+        // Zigzag, so that dates before 1970 stay short.
+        const auto count = value.time_since_epoch().count();
+        out.varint(static_cast<std::uint64_t>(count) << 1 ^
+                   static_cast<std::uint64_t>(count >> 63));
+    }
+    static void write(writer &out, rss::day value) {
+        out.varint(static_cast<std::uint8_t>(value));
+    }
+    static void write(writer &out, atom::rel value) {
+        out.varint(static_cast<std::uint8_t>(value));
+    }
+    static void write(writer &out,
+                      const std::pair<std::string, std::string> &value) {
+        out.string(value.first);
+        out.string(value.second);
+    }
+    template <typename T>
+    static void write(writer &out, const std::vector<T> &values) {
+        out.varint(values.size());
+        for (const auto &value : values)
+            write(out, value);
+    }
+    template <typename T>
+    static void write(writer &out, const boost::optional<T> &value) {
+        if (value)
+            write(out, value.value());
+    }
+
+    static void write(writer &out, const extension &value) {
+        out.varint(0);
+        write(out, value.namespace_uri_);
+        write(out, value.name_);
+        write(out, value.attributes_);
+        write(out, value.value_);
+        write(out, value.children_);
+    }
+    static void write(writer &out, const atom::link &value) {
+        out.varint((presence() << value.href_lang_ << value.length_
+                               << value.title_ << value.type_ << value.rel_)
+                       .mask());
+        write(out, value.href_);
+        write(out, value.href_lang_);
+        write(out, value.length_);
+        write(out, value.title_);
+        write(out, value.type_);
+        write(out, value.rel_);
+    }
+
+    static void write(writer &out, const rss::category &value) {
+        out.varint((presence() << value.domain_).mask());
+        write(out, value.value_);
+        write(out, value.domain_);
+    }
+    static void write(writer &out, const rss::cloud &value) {
+        out.varint(0);
+        write(out, value.domain_);
+        write(out, value.path_);
+        write(out, value.port_);
+        out.varint(static_cast<std::uint8_t>(value.protocol_));
+        write(out, value.register_procedure_);
+    }
+    static void write(writer &out, const rss::image &value) {
+        out.varint(
+            (presence() << value.width_ << value.height_ << value.description_)
+                .mask());
+        write(out, value.url_);
+        write(out, value.title_);
+        write(out, value.link_);
+        write(out, value.width_);
+        write(out, value.height_);
+        write(out, value.description_);
+    }
+    static void write(writer &out, const rss::text_input &value) {
+        out.varint(0);
+        write(out, value.title_);
+        write(out, value.description_);
+        write(out, value.name_);
+        write(out, value.link_);
+    }
+    static void write(writer &out, const rss::itunes::image &value) {
+        out.varint(0);
+        write(out, value.href_);
+    }
+    static void
+    write(writer &out,
+          const rss::itunes::channel_level::itunes_extensions &value) {
+        out.varint((presence() << value.image_ << value.new_feed_url_).mask());
+        write(out, value.image_);
+        write(out, value.new_feed_url_);
+    }
+    static void write(writer &out, const rss::enclosure &value) {
+        out.varint((presence() << value.length_).mask());
+        write(out, value.url_);
+        write(out, value.length_);
+        write(out, value.type_);
+    }
+    static void write(writer &out, const rss::guid &value) {
+        out.varint((presence() << value.is_perma_link_).mask());
+        write(out, value.value_);
+    }
+    static void write(writer &out, const rss::source &value) {
+        out.varint(0);
+        write(out, value.value_);
+        write(out, value.url_);
+    }
+    static void write(writer &out, const rss::item &value) {
+        out.varint((presence() << value.title_ << value.link_
+                               << value.description_ << value.author_
+                               << value.categories_ << value.comments_
+                               << value.enclosure_ << value.guid_
+                               << value.pub_date_ << value.source_
+                               << value.extensions_)
+                       .mask());
+        write(out, value.title_);
+        write(out, value.link_);
+        write(out, value.description_);
+        write(out, value.author_);
+        write(out, value.categories_);
+        write(out, value.comments_);
+        write(out, value.enclosure_);
+        write(out, value.guid_);
+        write(out, value.pub_date_);
+        write(out, value.source_);
+        write(out, value.extensions_);
+    }
+    static void write(writer &out, const rss::rss_data &value) {
+        out.varint(
+            (presence() << value.language_ << value.copyright_
+                        << value.managing_editor_ << value.web_master_
+                        << value.pub_date_ << value.last_build_date_
+                        << value.categories_ << value.generator_
+                        << value.docs_ << value.cloud_ << value.ttl_
+                        << value.image_ << value.text_input_
+                        << value.skip_hours_ << value.skip_days_
+                        << value.atom_link_ << value.itunes_
+                        << value.extensions_ << value.valid_utf8_)
+                .mask());
+        write(out, value.title_);
+        write(out, value.link_);
+        write(out, value.description_);
+        write(out, value.language_);
+        write(out, value.copyright_);
+        write(out, value.managing_editor_);
+        write(out, value.web_master_);
+        write(out, value.pub_date_);
+        write(out, value.last_build_date_);
+        write(out, value.categories_);
+        write(out, value.generator_);
+        write(out, value.docs_);
+        write(out, value.cloud_);
+        write(out, value.ttl_);
+        write(out, value.image_);
+        write(out, value.text_input_);
+        write(out, value.skip_hours_);
+        write(out, value.skip_days_);
+        write(out, value.items_);
+        write(out, value.atom_link_);
+        write(out, value.itunes_);
+        write(out, value.extensions_);
+    }
+
+    static void write(writer &out, const atom::text &value) {
+        out.varint(0);
+        write(out, value.value_);
+        out.varint(static_cast<std::uint8_t>(value.type_));
+    }
+    static void write(writer &out, const atom::person &value) {
+        out.varint((presence() << value.email_ << value.uri_).mask());
+        write(out, value.name_);
+        write(out, value.email_);
+        write(out, value.uri_);
+    }
+    static void write(writer &out, const atom::category &value) {
+        out.varint((presence() << value.scheme_ << value.label_).mask());
+        write(out, value.term_);
+        write(out, value.scheme_);
+        write(out, value.label_);
+    }
+    static void write(writer &out, const atom::generator &value) {
+        out.varint((presence() << value.uri_ << value.version_).mask());
+        write(out, value.value_);
+        write(out, value.uri_);
+        write(out, value.version_);
+    }
+    static void write(writer &out, const atom::entry &value) {
+        out.varint((presence() << value.authors_ << value.content_
+                               << value.links_ << value.summary_
+                               << value.categories_ << value.rights_
+                               << value.contributors_ << value.extensions_)
+                       .mask());
+        write(out, value.id_);
+        write(out, value.title_);
+        write(out, value.authors_);
+        write(out, value.content_);
+        write(out, value.links_);
+        write(out, value.summary_);
+        write(out, value.categories_);
+        write(out, value.rights_);
+        write(out, value.contributors_);
+        write(out, value.extensions_);
+    }
+    static void write(writer &out, const atom::atom_data &value) {
+        out.varint((presence() << value.authors_ << value.links_
+                               << value.categories_ << value.contributors_
+                               << value.generator_ << value.icon_
+                               << value.logo_ << value.rights_
+                               << value.subtitle_ << value.extensions_
+                               << value.valid_utf8_)
+                       .mask());
+        write(out, value.id_);
+        write(out, value.title_);
+        write(out, value.authors_);
+        write(out, value.links_);
+        write(out, value.categories_);
+        write(out, value.contributors_);
+        write(out, value.generator_);
+        write(out, value.icon_);
+        write(out, value.logo_);
+        write(out, value.rights_);
+        write(out, value.subtitle_);
+        write(out, value.entries_);
+        write(out, value.extensions_);
+    }
+
+    static std::string read(reader &in, tag<std::string>) {
+        return in.string();
+    }
+    static std::uint16_t read(reader &in, tag<std::uint16_t>) {
+        return static_cast<std::uint16_t>(in.varint(0xFFFF));
+    }
+    static std::uint64_t read(reader &in, tag<std::uint64_t>) {
+        return in.varint();
+    }
+    static seconds read(reader &in, tag<seconds>) {
+        const auto zigzag = in.varint();
+        const auto count = static_cast<seconds::rep>(zigzag >> 1) ^
+                           -static_cast<seconds::rep>(zigzag & 1);
+
+        return seconds(seconds::duration(count));
+    }
+    static rss::day read(reader &in, tag<rss::day>) {
+        return static_cast<rss::day>(
+            in.varint(static_cast<std::uint8_t>(rss::day::sunday)));
+    }
+    static atom::rel read(reader &in, tag<atom::rel>) {
+        return static_cast<atom::rel>(
+            in.varint(static_cast<std::uint8_t>(atom::rel::via)));
+    }
+    static std::pair<std::string, std::string>
+    read(reader &in, tag<std::pair<std::string, std::string>>) {
+        auto first = in.string();
+
+        return {std::move(first), in.string()};
+    }
+    template <typename T>
+    static std::vector<T> read(reader &in, tag<std::vector<T>>) {
+        std::vector<T> values;
+        const auto size = in.count();
+        values.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+            values.push_back(read(in, tag<T>()));
+
+        return values;
+    }
+    template <typename T>
+    static void read(reader &in, presence &has, boost::optional<T> &value) {
+        if (has.next())
+            value.emplace(read(in, tag<T>()));
+    }
+    template <typename T> static void read(reader &in, T &value) {
+        value = read(in, tag<T>());
+    }
+
+    static extension read(reader &in, tag<extension>) {
+        return read_extension(in, 0);
+    }
+    // Recursive, bounded at max_extension_depth (1024) levels so that a
+    // crafted image cannot exhaust the stack.
+    static extension read_extension(reader &in, std::size_t depth) {
+        if (depth > max_extension_depth)
+            throw std::runtime_error("nesting too deep");
+
+        in.varint();
+        extension value;
+        read(in, value.namespace_uri_);
+        read(in, value.name_);
+        read(in, value.attributes_);
+        read(in, value.value_);
+        const auto children = in.count();
+        value.children_.reserve(children);
+        for (std::size_t i = 0; i < children; ++i)
+            value.children_.push_back(read_extension(in, depth + 1));
+
+        return value;
+    }
+    static atom::link read(reader &in, tag<atom::link>) {
+        presence has(in.varint());
+        atom::link value;
+        read(in, value.href_);
+        read(in, has, value.href_lang_);
+        read(in, has, value.length_);
+        read(in, has, value.title_);
+        read(in, has, value.type_);
+        read(in, has, value.rel_);
+
+        return value;
+    }
+
+    static rss::category read(reader &in, tag<rss::category>) {
+        presence has(in.varint());
+        auto name = in.string();
+        boost::optional<std::string> domain;
+        read(in, has, domain);
+
+        return rss::category(std::move(name), std::move(domain));
+    }
+    static rss::cloud read(reader &in, tag<rss::cloud>) {
+        in.varint();
+        rss::cloud value;
+        read(in, value.domain_);
+        read(in, value.path_);
+        read(in, value.port_);
+        value.protocol_ = static_cast<rss::protocol>(
+            in.varint(static_cast<std::uint8_t>(rss::protocol::soap)));
+        read(in, value.register_procedure_);
+
+        return value;
+    }
+    static rss::image read(reader &in, tag<rss::image>) {
+        presence has(in.varint());
+        rss::image value;
+        read(in, value.url_);
+        read(in, value.title_);
+        read(in, value.link_);
+        read(in, has, value.width_);
+        read(in, has, value.height_);
+        read(in, has, value.description_);
+
+        return value;
+    }
+    static rss::text_input read(reader &in, tag<rss::text_input>) {
+        in.varint();
+        rss::text_input value;
+        read(in, value.title_);
+        read(in, value.description_);
+        read(in, value.name_);
+        read(in, value.link_);
+
+        return value;
+    }
+    static rss::itunes::image read(reader &in, tag<rss::itunes::image>) {
+        in.varint();
+        rss::itunes::image value;
+        read(in, value.href_);
+
+        return value;
+    }
+    static rss::itunes::channel_level::itunes_extensions
+    read(reader &in, tag<rss::itunes::channel_level::itunes_extensions>) {
+        presence has(in.varint());
+        rss::itunes::channel_level::itunes_extensions value;
+        read(in, has, value.image_);
+        read(in, has, value.new_feed_url_);
+
+        return value;
+    }
+    static rss::enclosure read(reader &in, tag<rss::enclosure>) {
+        presence has(in.varint());
+        auto url = in.string();
+        boost::optional<std::uint64_t> length;
+        read(in, has, length);
+
+        return rss::enclosure(std::move(url), std::move(length), in.string());
+    }
+    static rss::guid read(reader &in, tag<rss::guid>) {
+        presence has(in.varint());
+        const bool is_perma_link = has.next();
+
+        return rss::guid(in.string(), is_perma_link);
+    }
+    static rss::source read(reader &in, tag<rss::source>) {
+        in.varint();
+        auto value = in.string();
+
+        return rss::source(std::move(value), in.string());
+    }
+    static rss::item read(reader &in, tag<rss::item>) {
+        presence has(in.varint());
+        rss::item value;
+        read(in, has, value.title_);
+        read(in, has, value.link_);
+        read(in, has, value.description_);
+        read(in, has, value.author_);
+        read(in, has, value.categories_);
+        read(in, has, value.comments_);
+        read(in, has, value.enclosure_);
+        read(in, has, value.guid_);
+        read(in, has, value.pub_date_);
+        read(in, has, value.source_);
+        read(in, has, value.extensions_);
+
+        return value;
+    }
+    static rss::rss_data read(reader &in, tag<rss::rss_data>) {
+        presence has(in.varint());
+        rss::rss_data value;
+        read(in, value.title_);
+        read(in, value.link_);
+        read(in, value.description_);
+        read(in, has, value.language_);
+        read(in, has, value.copyright_);
+        read(in, has, value.managing_editor_);
+        read(in, has, value.web_master_);
+        read(in, has, value.pub_date_);
+        read(in, has, value.last_build_date_);
+        read(in, has, value.categories_);
+        read(in, has, value.generator_);
+        read(in, has, value.docs_);
+        read(in, has, value.cloud_);
+        read(in, has, value.ttl_);
+        read(in, has, value.image_);
+        read(in, has, value.text_input_);
+        read(in, has, value.skip_hours_);
+        read(in, has, value.skip_days_);
+        read(in, value.items_);
+        read(in, has, value.atom_link_);
+        read(in, has, value.itunes_);
+        read(in, has, value.extensions_);
+        value.valid_utf8_ = has.next();
+
+        return value;
+    }
+
+    // In place, text cannot be assigned.
+    static void read(reader &in, atom::text &value) {
+        in.varint();
+        read(in, value.value_);
+        value.type_ = static_cast<enum atom::text::type>(in.varint(
+            static_cast<std::uint8_t>(atom::text::type::xhtml)));
+    }
+    static atom::text read(reader &in, tag<atom::text>) {
+        atom::text value;
+        read(in, value);
+
+        return value;
+    }
+    static atom::person read(reader &in, tag<atom::person>) {
+        presence has(in.varint());
+        auto name = in.string();
+        boost::optional<std::string> email;
+        boost::optional<std::string> uri;
+        read(in, has, email);
+        read(in, has, uri);
+
+        return atom::person(std::move(name), std::move(email),
+                            std::move(uri));
+    }
+    static atom::category read(reader &in, tag<atom::category>) {
+        presence has(in.varint());
+        auto term = in.string();
+        boost::optional<std::string> scheme;
+        boost::optional<std::string> label;
+        read(in, has, scheme);
+        read(in, has, label);
+
+        return atom::category(std::move(term), std::move(scheme),
+                              std::move(label));
+    }
+    static atom::generator read(reader &in, tag<atom::generator>) {
+        presence has(in.varint());
+        auto name = in.string();
+        boost::optional<std::string> uri;
+        boost::optional<std::string> version;
+        read(in, has, uri);
+        read(in, has, version);
+
+        return atom::generator(std::move(name), std::move(uri),
+                               std::move(version));
+    }
+    static atom::entry read(reader &in, tag<atom::entry>) {
+        presence has(in.varint());
+        atom::entry value;
+        read(in, value.id_);
+        read(in, value.title_);
+        read(in, has, value.authors_);
+        read(in, has, value.content_);
+        read(in, has, value.links_);
+        read(in, has, value.summary_);
+        read(in, has, value.categories_);
+        read(in, has, value.rights_);
+        read(in, has, value.contributors_);
+        read(in, has, value.extensions_);
+
+        return value;
+    }
+    static atom::atom_data read(reader &in, tag<atom::atom_data>) {
+        presence has(in.varint());
+        atom::atom_data value;
+        read(in, value.id_);
+        read(in, value.title_);
+        read(in, has, value.authors_);
+        read(in, has, value.links_);
+        read(in, has, value.categories_);
+        read(in, has, value.contributors_);
+        read(in, has, value.generator_);
+        read(in, has, value.icon_);
+        read(in, has, value.logo_);
+        read(in, has, value.rights_);
+        read(in, has, value.subtitle_);
+        read(in, value.entries_);
+        read(in, has, value.extensions_);
+        value.valid_utf8_ = has.next();
+
+        return value;
+    }
+};
+}
+
+template <typename Feed>
+static std::string image_of(const Feed &feed, kind kind) {
+    std::string image;
+    writer out(image);
+    out.bytes(magic, sizeof(magic));
+    out.varint(version);
+    out.varint(static_cast<std::uint8_t>(kind));
+    detail::codec::write(out, feed);
+
+    return image;
+}
+
+template <typename Feed>
+static boost::optional<Feed> feed_of(boost::string_ref data, kind kind) {
+    try {
+        reader in(data);
+        if (!in.bytes(magic, sizeof(magic)) || in.varint() != version ||
+            in.varint() != static_cast<std::uint8_t>(kind)) {
+            log(log_level::error, "deserialize: not a feed image of this "
+                                  "kind and version");
+
+            return {};
+        }
+
+        auto feed = detail::codec::read(in, tag<Feed>());
+        if (in.remaining() != 0)
+            throw std::runtime_error("trailing bytes");
+
+        return std::move(feed);
+    } catch (const std::exception &e) {
+        log(log_level::error, std::string("deserialize: ") + e.what());
+
+        return {};
+    }
+}
+
+std::string serialize(const rss::rss_data &feed) {
+    return image_of(feed, kind::rss);
+}
+
+std::string serialize(const atom::atom_data &feed) {
+    return image_of(feed, kind::atom);
+}
+
+boost::optional<rss::rss_data> deserialize_rss(boost::string_ref data) {
+    return feed_of<rss::rss_data>(data, kind::rss);
+}
+
+boost::optional<atom::atom_data> deserialize_atom(boost::string_ref data) {
+    return feed_of<atom::atom_data>(data, kind::atom);
+}
+}
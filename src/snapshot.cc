@@ -0,0 +1,402 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+#include <feed/hash.h>
+#include <feed/log.h>
+#include <feed/serialization.h>
+#include <feed/snapshot.h>
+#include <ostream>
+
+namespace feed {
+// Every field is a little-endian 64-bit word, a string two: its offset in
+// the pool and its size.
+//
+// Header: magic and version, number of feeds, offset of the index, of the
+// feed records, of the item records, number of items, offset and size of
+// the pool. Index entries: hash64() of the URL, feed record.
+static const char magic[4] = {'F', 'P', 'S', 'N'};
+static const std::uint32_t version = 1;
+static const std::size_t header_bytes = 8 * 8;
+static const std::size_t index_bytes = 2 * 8;
+
+// Feed record: flags, URL, title, link, description, model, first item,
+// number of items, updated.
+static const std::size_t feed_bytes = 14 * 8;
+static const std::uint64_t atom_flag = 1;
+static const std::uint64_t updated_flag = 2;
+
+// Item record: flags, id, title, link, summary, pubDate.
+static const std::size_t item_bytes = 10 * 8;
+static const std::uint64_t pub_date_flag = 1;
+
+static std::uint64_t read64(const char *data) {
+    std::uint64_t value;
+    std::memcpy(&value, data, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static void put64(std::string &out, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i)
+        out += static_cast<char>(value >> (8 * i));
+}
+
+static boost::string_ref value(const boost::optional<std::string> &field) {
+    return field ? boost::string_ref(field.value()) : boost::string_ref();
+}
+
+static boost::string_ref value(const boost::optional<atom::text> &field) {
+    return field ? boost::string_ref(field->value()) : boost::string_ref();
+}
+
+// The alternate link, the first one if none is.
+static boost::string_ref
+alternate(const boost::optional<std::vector<atom::link>> &links) {
+    if (!links || links->empty())
+        return {};
+
+    for (const auto &link : links.value())
+        if (!link.rel() || link.rel().value() == atom::rel::alternate)
+            return link.href();
+
+    return links->front().href();
+}
+
+static std::uint64_t
+seconds(const std::chrono::time_point<std::chrono::system_clock,
+                                      std::chrono::seconds> &time) {
+    return static_cast<std::uint64_t>(time.time_since_epoch().count());
+}
+
+static std::chrono::time_point<std::chrono::system_clock, std::chrono::seconds>
+time_at(const char *word) {
+    return std::chrono::time_point<std::chrono::system_clock,
+                                   std::chrono::seconds>(
+        std::chrono::seconds(static_cast<std::int64_t>(read64(word))));
+}
+
+boost::optional<std::chrono::time_point<std::chrono::system_clock,
+                                        std::chrono::seconds>>
+snapshot_item::pub_date() const {
+    if ((read64(record_) & pub_date_flag) == 0)
+        return {};
+
+    return time_at(record_ + 9 * 8);
+}
+
+boost::string_ref snapshot_item::string(std::size_t word) const {
+    const auto offset = read64(record_ + word * 8);
+    const auto size = read64(record_ + word * 8 + 8);
+    if (offset > strings_size_ || size > strings_size_ - offset)
+        return {};
+
+    return boost::string_ref(strings_ + offset,
+                             static_cast<std::size_t>(size));
+}
+
+feed_format snapshot_feed::format() const {
+    return (read64(record_) & atom_flag) != 0 ? feed_format::atom
+                                              : feed_format::rss;
+}
+
+boost::optional<std::chrono::time_point<std::chrono::system_clock,
+                                        std::chrono::seconds>>
+snapshot_feed::updated() const {
+    if ((read64(record_) & updated_flag) == 0)
+        return {};
+
+    return time_at(record_ + 13 * 8);
+}
+
+std::size_t snapshot_feed::size() const {
+    return static_cast<std::size_t>(read64(record_ + 12 * 8));
+}
+
+snapshot_item snapshot_feed::item(std::size_t index) const {
+    return snapshot_item(
+        items_ + (read64(record_ + 11 * 8) + index) * item_bytes, strings_,
+        strings_size_);
+}
+
+boost::optional<rss::rss_data> snapshot_feed::load_rss() const {
+    const auto model = string(9);
+    if (format() != feed_format::rss || model.empty())
+        return {};
+
+    return deserialize_rss(model);
+}
+
+boost::optional<atom::atom_data> snapshot_feed::load_atom() const {
+    const auto model = string(9);
+    if (format() != feed_format::atom || model.empty())
+        return {};
+
+    return deserialize_atom(model);
+}
+
+boost::string_ref snapshot_feed::string(std::size_t word) const {
+    return boost::string_ref(
+        strings_ + read64(record_ + word * 8),
+        static_cast<std::size_t>(read64(record_ + word * 8 + 8)));
+}
+
+boost::optional<snapshot> snapshot::open(const std::string &path) {
+    try {
+        const boost::interprocess::file_mapping file(
+            path.c_str(), boost::interprocess::read_only);
+        const auto region =
+            std::make_shared<boost::interprocess::mapped_region>(
+                file, boost::interprocess::read_only);
+
+        auto result = from(
+            boost::string_ref(static_cast<const char *>(region->get_address()),
+                              region->get_size()));
+        if (result)
+            result->mapping_ = region;
+
+        return result;
+    } catch (const boost::interprocess::interprocess_exception &e) {
+        log(log_level::error, path + ": " + e.what());
+
+        return {};
+    }
+}
+
+boost::optional<snapshot> snapshot::from(boost::string_ref image) {
+    const char *const data = image.data();
+    const std::uint64_t size = image.size();
+    // Whether count records of bytes each fit from offset on.
+    const auto fits = [size](std::uint64_t offset, std::uint64_t count,
+                             std::uint64_t bytes) {
+        return offset <= size && count <= (size - offset) / bytes;
+    };
+
+    if (size < header_bytes || std::memcmp(data, magic, sizeof(magic)) != 0 ||
+        read64(data) >> 32 != version) {
+        log(log_level::error, "snapshot: not a snapshot of this version");
+
+        return {};
+    }
+
+    const auto feeds = read64(data + 8);
+    const auto index = read64(data + 2 * 8);
+    const auto feed_records = read64(data + 3 * 8);
+    const auto item_records = read64(data + 4 * 8);
+    const auto items = read64(data + 5 * 8);
+    const auto strings = read64(data + 6 * 8);
+    const auto strings_size = read64(data + 7 * 8);
+    if (!fits(index, feeds, index_bytes) ||
+        !fits(feed_records, feeds, feed_bytes) ||
+        !fits(item_records, items, item_bytes) ||
+        !fits(strings, strings_size, 1)) {
+        log(log_level::error, "snapshot: truncated");
+
+        return {};
+    }
+
+    snapshot result;
+    result.index_ = data + index;
+    result.feed_records_ = data + feed_records;
+    result.item_records_ = data + item_records;
+    result.strings_ = data + strings;
+    result.feeds_ = static_cast<std::size_t>(feeds);
+    result.items_ = items;
+    result.strings_size_ = strings_size;
+
+    return std::move(result);
+}
+
+boost::optional<snapshot_feed> snapshot::find(boost::string_ref uri) const {
+    const auto hash = hash64(uri);
+
+    std::size_t first = 0;
+    std::size_t count = feeds_;
+    while (count > 0) {
+        const auto half = count / 2;
+        if (read64(index_ + (first + half) * index_bytes) < hash) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    for (; first < feeds_ && read64(index_ + first * index_bytes) == hash;
+         ++first) {
+        const auto feed = checked(read64(index_ + first * index_bytes + 8));
+        if (feed && feed->uri() == uri)
+            return feed;
+    }
+
+    return {};
+}
+
+boost::optional<snapshot_feed> snapshot::at(std::size_t index) const {
+    if (index >= feeds_)
+        return {};
+
+    return checked(read64(index_ + index * index_bytes + 8));
+}
+
+boost::optional<snapshot_feed> snapshot::checked(std::uint64_t index) const {
+    if (index >= feeds_)
+        return {};
+
+    const char *const record = feed_records_ + index * feed_bytes;
+    const auto first = read64(record + 11 * 8);
+    const auto count = read64(record + 12 * 8);
+    if (!in_pool(record, 1) || !in_pool(record, 3) || !in_pool(record, 5) ||
+        !in_pool(record, 7) || !in_pool(record, 9) || first > items_ ||
+        count > items_ - first)
+        return {};
+
+    return snapshot_feed(record, item_records_, strings_, strings_size_);
+}
+
+bool snapshot::in_pool(const char *record, std::size_t word) const {
+    const auto offset = read64(record + word * 8);
+    const auto size = read64(record + word * 8 + 8);
+
+    return offset <= strings_size_ && size <= strings_size_ - offset;
+}
+
+void snapshot_writer::add(const std::string &uri, const rss::rss_data &feed) {
+    const auto &updated =
+        feed.last_build_date() ? feed.last_build_date() : feed.pub_date();
+
+    std::string record;
+    put64(record, updated ? updated_flag : 0);
+    add_string(record, uri);
+    add_string(record, feed.title());
+    add_string(record, feed.link());
+    add_string(record, feed.description());
+    add_string(record, models_ ? serialize(feed) : std::string());
+    put64(record, items_);
+    put64(record, feed.items().size());
+    put64(record, updated ? seconds(updated.value()) : 0);
+
+    for (const auto &item : feed.items()) {
+        put64(item_records_, item.pub_date() ? pub_date_flag : 0);
+        add_string(item_records_, identity(item));
+        add_string(item_records_, value(item.title()));
+        add_string(item_records_, value(item.link()));
+        add_string(item_records_, value(item.description()));
+        put64(item_records_,
+              item.pub_date() ? seconds(item.pub_date().value()) : 0);
+    }
+    items_ += feed.items().size();
+
+    add_feed(uri, std::move(record));
+}
+
+void snapshot_writer::add(const std::string &uri,
+                          const atom::atom_data &feed) {
+    std::string record;
+    put64(record, atom_flag);
+    add_string(record, uri);
+    add_string(record, feed.title().value());
+    add_string(record, alternate(feed.links()));
+    add_string(record, value(feed.subtitle()));
+    add_string(record, models_ ? serialize(feed) : std::string());
+    put64(record, items_);
+    put64(record, feed.entries().size());
+    put64(record, 0);
+
+    for (const auto &entry : feed.entries()) {
+        put64(item_records_, 0);
+        add_string(item_records_, entry.id());
+        add_string(item_records_, entry.title().value());
+        add_string(item_records_, alternate(entry.links()));
+        add_string(item_records_, value(entry.summary()));
+        put64(item_records_, 0);
+    }
+    items_ += feed.entries().size();
+
+    add_feed(uri, std::move(record));
+}
+
+void snapshot_writer::save(std::ostream &out) const {
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> index;
+    index.reserve(uris_.size());
+    for (const auto &entry : uris_)
+        index.emplace_back(hash64(entry.first), entry.second);
+    std::sort(index.begin(), index.end());
+
+    const std::uint64_t feed_records =
+        header_bytes + index.size() * index_bytes;
+    const std::uint64_t item_records = feed_records + feed_records_.size();
+    const std::uint64_t strings = item_records + item_records_.size();
+
+    std::string header(magic, sizeof(magic));
+    for (int i = 0; i < 4; ++i)
+        header += static_cast<char>(version >> (8 * i));
+    put64(header, index.size());
+    put64(header, header_bytes);
+    put64(header, feed_records);
+    put64(header, item_records);
+    put64(header, items_);
+    put64(header, strings);
+    put64(header, strings_.size());
+    for (const auto &entry : index) {
+        put64(header, entry.first);
+        put64(header, entry.second);
+    }
+
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out.write(feed_records_.data(),
+              static_cast<std::streamsize>(feed_records_.size()));
+    out.write(item_records_.data(),
+              static_cast<std::streamsize>(item_records_.size()));
+    out.write(strings_.data(), static_cast<std::streamsize>(strings_.size()));
+}
+
+void snapshot_writer::add_string(std::string &record,
+                                 boost::string_ref value) {
+    put64(record, strings_.size());
+    put64(record, value.size());
+    strings_.append(value.data(), value.size());
+}
+
+void snapshot_writer::add_feed(const std::string &uri, std::string record) {
+    const auto it = uris_.find(uri);
+    if (it != uris_.end()) {
+        feed_records_.replace(it->second * feed_bytes, feed_bytes, record);
+
+        return;
+    }
+
+    uris_.emplace(uri, feed_records_.size() / feed_bytes);
+    feed_records_ += record;
+}
+}
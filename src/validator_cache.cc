@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <feed/validator_cache.h>
+
+namespace feed {
+boost::optional<validators>
+validator_cache::find(const std::string &uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = entries_.find(uri);
+    if (it == entries_.end())
+        return {};
+
+    return it->second;
+}
+
+void validator_cache::store(const std::string &uri, validators entry) {
+    if (!entry.etag && !entry.last_modified && !entry.fingerprint) {
+        erase(uri);
+
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[uri] = std::move(entry);
+}
+
+void validator_cache::erase(const std::string &uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(uri);
+}
+
+void validator_cache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+std::size_t validator_cache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return entries_.size();
+}
+}
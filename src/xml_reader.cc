@@ -0,0 +1,405 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the feed_parser.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <feed/xml_reader.h>
+
+namespace {
+bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void append_utf8(std::uint32_t code, std::string &out) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+// Decodes the reference between '&' and ';', returns false if it is not one
+// this parser knows about.
+bool decode_reference(boost::string_ref ref, std::string &out) {
+    if (ref == "lt")
+        out += '<';
+    else if (ref == "gt")
+        out += '>';
+    else if (ref == "amp")
+        out += '&';
+    else if (ref == "quot")
+        out += '"';
+    else if (ref == "apos")
+        out += '\'';
+    else if (ref.size() > 1 && ref[0] == '#') {
+        const bool hex = ref[1] == 'x' || ref[1] == 'X';
+        ref.remove_prefix(hex ? 2 : 1);
+        if (ref.empty())
+            return false;
+
+        std::uint32_t code = 0;
+        for (const char c : ref) {
+            std::uint32_t digit;
+            if (c >= '0' && c <= '9')
+                digit = static_cast<std::uint32_t>(c - '0');
+            else if (hex && c >= 'a' && c <= 'f')
+                digit = static_cast<std::uint32_t>(c - 'a' + 10);
+            else if (hex && c >= 'A' && c <= 'F')
+                digit = static_cast<std::uint32_t>(c - 'A' + 10);
+            else
+                return false;
+
+            code = code * (hex ? 16 : 10) + digit;
+            if (code > 0x10FFFF)
+                return false;
+        }
+        // Not characters, the reference is kept as it is.
+        if (code == 0 || (code >= 0xD800 && code <= 0xDFFF))
+            return false;
+
+        append_utf8(code, out);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+}
+
+namespace feed {
+xml_reader::token xml_reader::next() {
+    if (pending_end_) {
+        pending_end_ = false;
+        close();
+
+        return token::end_element;
+    }
+
+    if (pos_ == begin_ && end_ - begin_ >= 3 &&
+        std::memcmp(begin_, "\xEF\xBB\xBF", 3) == 0)
+        pos_ += 3;
+
+    while (pos_ != end_) {
+        if (*pos_ != '<') {
+            const char *start = pos_;
+            const auto bracket = static_cast<const char *>(
+                std::memchr(pos_, '<', static_cast<std::size_t>(end_ - pos_)));
+            pos_ = bracket ? bracket : end_;
+
+            if (open_.empty()) {
+                for (const char *c = start; c != pos_; ++c)
+                    if (!is_whitespace(*c)) {
+                        pos_ = c;
+                        fail("expected '<'");
+                    }
+
+                continue;
+            }
+
+            text_ = boost::string_ref(start,
+                                      static_cast<std::size_t>(pos_ - start));
+            cdata_ = false;
+
+            return token::text;
+        }
+
+        const boost::string_ref rest(pos_,
+                                     static_cast<std::size_t>(end_ - pos_));
+        if (rest.starts_with("<!--")) {
+            pos_ += 4;
+            skip_until("-->");
+
+            continue;
+        }
+        if (rest.starts_with("<![CDATA[")) {
+            pos_ += 9;
+            const char *start = pos_;
+            skip_until("]]>");
+            if (open_.empty())
+                continue;
+
+            text_ = boost::string_ref(
+                start, static_cast<std::size_t>(pos_ - 3 - start));
+            cdata_ = true;
+
+            return token::text;
+        }
+        if (rest.starts_with("<!")) {
+            skip_doctype();
+
+            continue;
+        }
+        if (rest.starts_with("<?")) {
+            pos_ += 2;
+            skip_until("?>");
+
+            continue;
+        }
+
+        if (rest.starts_with("</")) {
+            pos_ += 2;
+            name_ = scan_name();
+            skip_whitespace();
+            if (pos_ == end_ || *pos_ != '>')
+                fail("expected '>'");
+            ++pos_;
+
+            if (open_.empty())
+                fail("unexpected end tag");
+            close();
+
+            return token::end_element;
+        }
+
+        if (max_depth_ != 0 && open_.size() >= max_depth_)
+            fail("elements nested too deeply");
+
+        element_ = pos_++;
+        name_ = scan_name();
+        attributes_.clear();
+
+        for (;;) {
+            skip_whitespace();
+            if (pos_ == end_)
+                fail("unexpected end of document");
+
+            if (*pos_ == '>') {
+                ++pos_;
+
+                break;
+            }
+            if (*pos_ == '/') {
+                if (end_ - pos_ < 2 || pos_[1] != '>')
+                    fail("expected '>'");
+                pos_ += 2;
+                pending_end_ = true;
+
+                break;
+            }
+
+            attribute attr;
+            attr.name = scan_name();
+            skip_whitespace();
+            if (pos_ == end_ || *pos_ != '=')
+                fail("expected '='");
+            ++pos_;
+            skip_whitespace();
+            if (pos_ == end_ || (*pos_ != '"' && *pos_ != '\''))
+                fail("expected ' or \"");
+
+            const char quote = *pos_++;
+            const auto close = static_cast<const char *>(std::memchr(
+                pos_, quote, static_cast<std::size_t>(end_ - pos_)));
+            if (!close) {
+                pos_ = end_;
+                fail("unexpected end of document");
+            }
+            attr.value =
+                boost::string_ref(pos_, static_cast<std::size_t>(close - pos_));
+            pos_ = close + 1;
+
+            attributes_.push_back(attr);
+        }
+
+        for (const auto &attr : attributes_)
+            if (attr.name.starts_with("xmlns") &&
+                (attr.name.size() == 5 || attr.name[5] == ':'))
+                bindings_.push_back(
+                    {attr.name.size() == 5 ? boost::string_ref()
+                                           : attr.name.substr(6),
+                     attr.value, open_.size() + 1});
+
+        open_.push_back(name_);
+
+        return token::start_element;
+    }
+
+    if (!open_.empty())
+        fail("unexpected end of document");
+
+    return token::end_document;
+}
+
+void xml_reader::skip() {
+    const std::size_t depth = open_.size();
+
+    while (next() != token::end_element || open_.size() >= depth) {
+    }
+}
+
+void xml_reader::skip_to(std::size_t offset) {
+    pos_ = begin_ + offset;
+    pending_end_ = false;
+    close();
+}
+
+boost::optional<boost::string_ref>
+xml_reader::attribute_value(boost::string_ref name) const {
+    for (const auto &attr : attributes_)
+        if (attr.name == name)
+            return attr.value;
+
+    return {};
+}
+
+boost::string_ref xml_reader::prefix() const {
+    const auto colon = name_.find(':');
+
+    return colon == boost::string_ref::npos ? boost::string_ref()
+                                            : name_.substr(0, colon);
+}
+
+boost::string_ref xml_reader::local_name() const {
+    const auto colon = name_.find(':');
+
+    return colon == boost::string_ref::npos ? name_ : name_.substr(colon + 1);
+}
+
+boost::string_ref xml_reader::resolve(boost::string_ref prefix) const {
+    for (auto binding = bindings_.rbegin(); binding != bindings_.rend();
+         ++binding)
+        if (binding->prefix == prefix)
+            return binding->uri;
+
+    if (prefix == "xml")
+        return "http://www.w3.org/XML/1998/namespace";
+
+    return {};
+}
+
+bool xml_reader::bound(boost::string_ref uri) const {
+    for (const auto &binding : bindings_)
+        if (binding.uri == uri)
+            return true;
+
+    return false;
+}
+
+std::string xml_reader::path() const {
+    std::string path;
+    for (const auto &name : open_) {
+        if (!path.empty())
+            path += '/';
+        path.append(name.data(), name.size());
+    }
+
+    return path;
+}
+
+void xml_reader::close() {
+    open_.pop_back();
+    while (!bindings_.empty() && bindings_.back().depth > open_.size())
+        bindings_.pop_back();
+}
+
+void xml_reader::skip_until(const char *terminator) {
+    const boost::string_ref rest(pos_, static_cast<std::size_t>(end_ - pos_));
+    const auto found = rest.find(terminator);
+    if (found == boost::string_ref::npos) {
+        pos_ = end_;
+        fail("unexpected end of document");
+    }
+
+    pos_ += found + std::strlen(terminator);
+}
+
+void xml_reader::skip_doctype() {
+    int brackets = 0;
+    for (pos_ += 2; pos_ != end_; ++pos_)
+        if (*pos_ == '[')
+            ++brackets;
+        else if (*pos_ == ']')
+            --brackets;
+        else if (*pos_ == '>' && brackets <= 0) {
+            ++pos_;
+
+            return;
+        }
+
+    fail("unexpected end of document");
+}
+
+boost::string_ref xml_reader::scan_name() {
+    const char *start = pos_;
+    while (pos_ != end_ && !is_whitespace(*pos_) && *pos_ != '/' &&
+           *pos_ != '>' && *pos_ != '=')
+        ++pos_;
+    if (pos_ == start)
+        fail("expected name");
+
+    return boost::string_ref(start, static_cast<std::size_t>(pos_ - start));
+}
+
+void xml_reader::skip_whitespace() {
+    while (pos_ != end_ && is_whitespace(*pos_))
+        ++pos_;
+}
+
+void xml_reader::fail(const char *what) const { throw xml_error(what, offset()); }
+
+void decode_xml(boost::string_ref raw, std::string &out) {
+    const char *pos = raw.data();
+    const char *const end = pos + raw.size();
+
+    while (pos != end) {
+        const auto amp = static_cast<const char *>(
+            std::memchr(pos, '&', static_cast<std::size_t>(end - pos)));
+        if (!amp) {
+            out.append(pos, end);
+
+            return;
+        }
+        out.append(pos, amp);
+
+        // "&#x10FFFF;" is the longest reference worth looking at.
+        const std::size_t window =
+            std::min<std::size_t>(static_cast<std::size_t>(end - amp), 11);
+        const auto semicolon =
+            static_cast<const char *>(std::memchr(amp, ';', window));
+        if (semicolon &&
+            decode_reference(boost::string_ref(amp + 1, static_cast<std::size_t>(
+                                                            semicolon - amp - 1)),
+                             out)) {
+            pos = semicolon + 1;
+        } else {
+            out += '&';
+            pos = amp + 1;
+        }
+    }
+}
+}
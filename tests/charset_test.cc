@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the tests of the feed_parser.
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of the feed_parser library nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+****************************************************************************/
+
+// Checks that repair_utf8() replaces each maximal subpart of an ill-formed
+// sequence with one U+FFFD, as in table 3-8 of the Unicode standard.
+
+#include <cstdio>
+#include <feed/charset.h>
+#include <string>
+
+namespace {
+int failures = 0;
+
+// U+FFFD.
+const std::string r = "\xEF\xBF\xBD";
+
+void check(const std::string &input, const std::string &expected,
+           const char *what) {
+    std::string repaired;
+    feed::repair_utf8(input, repaired);
+    if (repaired != expected) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        ++failures;
+    }
+}
+}
+
+int main() {
+    check("a\xE2\x82\xAC\xF0\x9F\x98\x80z", "a\xE2\x82\xAC\xF0\x9F\x98\x80z",
+          "well-formed kept");
+    check("a\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64",
+          "a" + r + r + r + "b" + r + "c" + r + r + "d", "table 3-8");
+
+    check("\xE2\x82", r, "truncated at the end");
+    check("\xF0\x9F\x98", r, "truncated 4-byte at the end");
+    check("\xE2\x82x", r + "x", "truncated before ASCII");
+    check("\xF0\x9F\xE2\x82\xAC", r + "\xE2\x82\xAC", "truncated before lead");
+
+    check("\xC0\xAF", r + r, "overlong 2-byte");
+    check("\xE0\x80\xAF", r + r + r, "overlong 3-byte");
+    check("\xF0\x80\x80\xAF", r + r + r + r, "overlong 4-byte");
+
+    check("\xED\xA0\x80", r + r + r, "high surrogate");
+    check("\xED\xBF\xBF", r + r + r, "low surrogate");
+    check("\xF4\x90\x80\x80", r + r + r + r, "past U+10FFFF");
+    check("\xF5\x80", r + r, "invalid lead");
+
+    std::printf("%d failures\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
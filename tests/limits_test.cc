@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the tests of the feed_parser.
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of the feed_parser library nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+****************************************************************************/
+
+// Parses documents whose extensions nest far deeper than any real feed, under
+// both limit policies, and checks that they fail or are cut short rather
+// than exhausting the stack.
+
+#include <cstdio>
+#include <feed/atom_parser.h>
+#include <feed/rss_parser.h>
+#include <string>
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const std::string &what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+// depth media:group elements, one inside the other.
+std::string nested(std::size_t depth) {
+    std::string elements;
+    for (std::size_t i = 0; i < depth; ++i)
+        elements += "<media:group>";
+    for (std::size_t i = 0; i < depth; ++i)
+        elements += "</media:group>";
+
+    return elements;
+}
+
+std::string rss(std::size_t depth) {
+    return "<rss version=\"2.0\" xmlns:media=\"http://search.yahoo.com/mrss/\">"
+           "<channel><title>t</title><link>http://example.com/</link>"
+           "<description>d</description><item><title>i</title>"
+           "<enclosure url=\"http://example.com/a.mp3\" length=\"1\" "
+           "type=\"audio/mpeg\"/>" +
+           nested(depth) + "</item></channel></rss>";
+}
+
+std::string atom(std::size_t depth) {
+    return "<feed xmlns=\"http://www.w3.org/2005/Atom\" "
+           "xmlns:media=\"http://search.yahoo.com/mrss/\"><id>f</id>"
+           "<title>t</title><entry><id>e</id><title>e</title>" +
+           nested(depth) + "</entry></feed>";
+}
+
+// Levels of the first extension and its first children.
+std::size_t depth(const boost::optional<std::vector<feed::extension>> &list) {
+    if (!list || list->empty())
+        return 0;
+
+    std::size_t levels = 1;
+    for (const auto *element = &list->front(); !element->children().empty();
+         element = &element->children().front())
+        ++levels;
+
+    return levels;
+}
+}
+
+int main() {
+    const auto extensions = feed::extension_registry::common();
+    feed::parse_options fail;
+    fail.extensions = &extensions;
+    feed::parse_options truncate = fail;
+    truncate.limits.policy = feed::limit_policy::truncate;
+
+    const auto shallow = feed::rss::parse_rss(rss(10), fail);
+    check(shallow && depth(shallow->items().front().extensions()) == 10,
+          "rss: 10 levels kept");
+
+    const std::size_t deep = 100000;
+    check(!feed::rss::parse_rss(rss(deep), fail), "rss: deep fails");
+    check(!feed::atom::parse_atom(atom(deep), fail), "atom: deep fails");
+
+    const auto cut = feed::rss::parse_rss(rss(deep), truncate);
+    check(cut && depth(cut->items().front().extensions()) == 256,
+          "rss: deep cut to 256 levels");
+    const auto entry = feed::atom::parse_atom(atom(deep), truncate);
+    check(entry && depth(entry->entries().front().extensions()) == 256,
+          "atom: deep cut to 256 levels");
+
+    std::printf("%d failures\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,327 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the tests of the feed_parser.
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of the feed_parser library nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+****************************************************************************/
+
+// Parses the sample feeds in the data directory and compares every field the
+// parsers expose with the matching .expected file. The expected output was
+// produced by the property_tree based parsers this library used before the
+// streaming tokenizer, so a difference here is a change in behaviour.
+
+#include <cstdio>
+#include <feed/atom_parser.h>
+#include <feed/rss_parser.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::string read(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+
+    return content.str();
+}
+
+class dumper {
+  public:
+    template <typename T>
+    void field(const char *name, const boost::optional<T> &value) {
+        if (value)
+            field(name, *value);
+        else
+            out_ << name << " -\n";
+    }
+
+    template <typename T> void field(const char *name, const T &value) {
+        out_ << name << ": " << value << '\n';
+    }
+
+    template <typename T>
+    void date(const char *name, const boost::optional<T> &value) {
+        if (value)
+            field(name, value->time_since_epoch().count());
+        else
+            field(name, boost::optional<int>());
+    }
+
+    void line(const char *text) { out_ << text << '\n'; }
+
+    std::string str() const { return out_.str(); }
+
+  private:
+    std::ostringstream out_;
+};
+
+void dump(dumper &out, const feed::atom::link &link) {
+    out.field("href", link.href());
+    out.field("hreflang", link.href_lang());
+    out.field("length", link.length());
+    out.field("link title", link.title());
+    out.field("type", link.type());
+    if (link.rel())
+        out.field("rel", static_cast<int>(*link.rel()));
+}
+
+void dump(dumper &out, const char *name, const feed::atom::text &text) {
+    out.field(name, text.value());
+    out.field("text type", static_cast<int>(text.type()));
+}
+
+void dump(dumper &out, const char *name,
+          const boost::optional<feed::atom::text> &text) {
+    if (text)
+        dump(out, name, *text);
+    else
+        out.field(name, boost::optional<int>());
+}
+
+void dump(dumper &out, const char *name,
+          const boost::optional<std::vector<feed::atom::person>> &people) {
+    out.line(name);
+    if (people)
+        for (const auto &person : *people) {
+            out.field("name", person.name());
+            out.field("email", person.email());
+            out.field("uri", person.uri());
+        }
+}
+
+void dump(dumper &out,
+          const boost::optional<std::vector<feed::atom::category>> &list) {
+    out.line("categories");
+    if (list)
+        for (const auto &category : *list) {
+            out.field("term", category.term());
+            out.field("scheme", category.scheme());
+            out.field("label", category.label());
+        }
+}
+
+void dump(dumper &out,
+          const boost::optional<std::vector<feed::atom::link>> &list) {
+    out.line("links");
+    if (list)
+        for (const auto &link : *list)
+            dump(out, link);
+}
+
+void dump(dumper &out,
+          const boost::optional<std::vector<feed::rss::category>> &list) {
+    out.line("categories");
+    if (list)
+        for (const auto &category : *list) {
+            out.field("category", category.value());
+            out.field("domain", category.domain());
+        }
+}
+
+std::string dump_rss(const std::string &document) {
+    dumper out;
+    const auto data = feed::rss::parse_rss(document);
+    if (!data) {
+        out.line("failed");
+        return out.str();
+    }
+
+    out.field("title", data->title());
+    out.field("link", data->link());
+    out.field("description", data->description());
+    out.field("language", data->language());
+    out.field("copyright", data->copyright());
+    out.field("managing editor", data->managing_editor());
+    out.field("web master", data->web_master());
+    out.date("pub date", data->pub_date());
+    out.date("last build date", data->last_build_date());
+    dump(out, data->categories());
+    out.field("generator", data->generator());
+    out.field("docs", data->docs());
+    if (data->cloud()) {
+        const auto &cloud = *data->cloud();
+        out.field("cloud domain", cloud.domain());
+        out.field("cloud port", cloud.port());
+        out.field("cloud path", cloud.path());
+        out.field("cloud procedure", cloud.register_procedure());
+        out.field("cloud protocol", static_cast<int>(cloud.protocol()));
+    }
+    out.field("ttl", data->ttl());
+    if (data->image()) {
+        const auto &image = *data->image();
+        out.field("image url", image.url());
+        out.field("image title", image.title());
+        out.field("image link", image.link());
+        out.field("image width", image.width());
+        out.field("image height", image.height());
+        out.field("image description", image.description());
+    }
+    if (data->text_input()) {
+        const auto &input = *data->text_input();
+        out.field("input title", input.title());
+        out.field("input description", input.description());
+        out.field("input name", input.name());
+        out.field("input link", input.link());
+    }
+    if (data->skip_hours())
+        for (const auto hour : *data->skip_hours())
+            out.field("skip hour", static_cast<int>(hour));
+    if (data->skip_days())
+        for (const auto day : *data->skip_days())
+            out.field("skip day", static_cast<int>(day));
+    if (data->atom_link())
+        dump(out, *data->atom_link());
+    if (data->itunes())
+        out.field("new feed url", data->itunes()->new_feed_url());
+
+    for (const auto &item : data->items()) {
+        out.line("item");
+        out.field("title", item.title());
+        out.field("link", item.link());
+        out.field("description", item.description());
+        out.field("author", item.author());
+        dump(out, item.categories());
+        out.field("comments", item.comments());
+        if (item.enclosure()) {
+            out.field("enclosure url", item.enclosure()->url());
+            out.field("enclosure length", item.enclosure()->length());
+            out.field("enclosure type", item.enclosure()->type());
+        }
+        if (item.guid()) {
+            out.field("guid", item.guid()->value());
+            out.field("permalink", item.guid()->is_perma_link());
+        }
+        out.date("pub date", item.pub_date());
+        if (item.source()) {
+            out.field("source", item.source()->value());
+            out.field("source url", item.source()->url());
+        }
+    }
+
+    return out.str();
+}
+
+std::string dump_atom(const std::string &document) {
+    dumper out;
+    const auto data = feed::atom::parse_atom(document);
+    if (!data) {
+        out.line("failed");
+        return out.str();
+    }
+
+    out.field("id", data->id());
+    dump(out, "title", data->title());
+    dump(out, "authors", data->authors());
+    dump(out, data->links());
+    dump(out, data->categories());
+    dump(out, "contributors", data->contributors());
+    if (data->generator()) {
+        out.field("generator", data->generator()->value());
+        out.field("generator uri", data->generator()->uri());
+        out.field("generator version", data->generator()->version());
+    }
+    out.field("icon", data->icon());
+    out.field("logo", data->logo());
+    dump(out, "rights", data->rights());
+    dump(out, "subtitle", data->subtitle());
+
+    for (const auto &entry : data->entries()) {
+        out.line("entry");
+        out.field("id", entry.id());
+        dump(out, "title", entry.title());
+        dump(out, "authors", entry.authors());
+        dump(out, "content", entry.content());
+        dump(out, entry.links());
+        dump(out, "summary", entry.summary());
+        dump(out, entry.categories());
+        dump(out, "rights", entry.rights());
+        dump(out, "contributors", entry.contributors());
+    }
+
+    return out.str();
+}
+
+// Reports the first line where the two dumps disagree.
+bool compare(const std::string &name, const std::string &expected,
+             const std::string &actual) {
+    if (expected == actual)
+        return true;
+
+    std::istringstream left(expected), right(actual);
+    std::string want, got;
+    for (std::size_t line = 1;; ++line) {
+        const bool more_left = static_cast<bool>(std::getline(left, want));
+        const bool more_right = static_cast<bool>(std::getline(right, got));
+        if (!more_left && !more_right)
+            break;
+        if (!more_left || !more_right || want != got) {
+            std::fprintf(stderr, "%s:%zu: expected \"%s\", got \"%s\"\n",
+                         name.c_str(), line, more_left ? want.c_str() : "",
+                         more_right ? got.c_str() : "");
+            break;
+        }
+    }
+
+    return false;
+}
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s data-directory\n", argv[0]);
+        return 2;
+    }
+
+    const std::string directory = argv[1];
+    const std::vector<std::string> rss_feeds = {"news.rss", "podcast.rss"};
+    const std::vector<std::string> atom_feeds = {"blog.atom", "legacy.atom",
+                                                 "releases.atom"};
+
+    int failures = 0;
+    for (const auto &name : rss_feeds) {
+        const auto path = directory + '/' + name;
+        if (!compare(name, read(path + ".expected"), dump_rss(read(path))))
+            ++failures;
+    }
+    for (const auto &name : atom_feeds) {
+        const auto path = directory + '/' + name;
+        if (!compare(name, read(path + ".expected"), dump_atom(read(path))))
+            ++failures;
+    }
+
+    std::printf("%d failures\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
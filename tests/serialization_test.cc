@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the tests of the feed_parser.
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of the feed_parser library nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+****************************************************************************/
+
+// Round-trips documents of tools/feed_generator, whose path is the only
+// argument, through parse, serialize, deserialize and serialize again, and
+// checks that images that are truncated, have trailing bytes or are of the
+// other kind are rejected.
+
+#include <cstdio>
+#include <cstdlib>
+#include <feed/serialization.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const std::string &what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+std::string generate(const std::string &generator, const std::string &format,
+                     int seed) {
+    const std::string path = "serialization_test." + format;
+    const std::string command = '"' + generator + "\" -f " + format +
+                                " -s " + std::to_string(seed) +
+                                " -n 8 --optional-rate 0.6 -o " + path;
+    if (std::system(command.c_str()) != 0)
+        return std::string();
+
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+
+    return content.str();
+}
+
+// serialize() of what deserialize() returns, empty if it fails.
+std::string again(const std::string &image, const feed::rss::rss_data *) {
+    const auto feed = feed::deserialize_rss(image);
+
+    return feed ? feed::serialize(feed.value()) : std::string();
+}
+
+std::string again(const std::string &image, const feed::atom::atom_data *) {
+    const auto feed = feed::deserialize_atom(image);
+
+    return feed ? feed::serialize(feed.value()) : std::string();
+}
+
+template <typename Feed>
+void round_trip(const Feed &feed, const std::string &name) {
+    const auto image = feed::serialize(feed);
+    check(again(image, static_cast<const Feed *>(nullptr)) == image,
+          name + ": round trip");
+
+    for (std::size_t size = 0; size < image.size();
+         size += image.size() / 61 + 1)
+        check(again(image.substr(0, size),
+                    static_cast<const Feed *>(nullptr))
+                  .empty(),
+              name + ": truncated to " + std::to_string(size));
+    check(again(image + '\0', static_cast<const Feed *>(nullptr)).empty(),
+          name + ": trailing byte");
+}
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s feed_generator\n", argv[0]);
+
+        return 2;
+    }
+
+    feed::parse_options options;
+    const auto extensions = feed::extension_registry::common();
+    options.extensions = &extensions;
+
+    for (int seed = 1; seed <= 50; ++seed) {
+        const auto name = std::to_string(seed);
+
+        const auto rss =
+            feed::rss::parse_rss(generate(argv[1], "rss", seed), options);
+        check(static_cast<bool>(rss), "rss " + name + ": parse");
+        if (rss) {
+            round_trip(rss.value(), "rss " + name);
+            check(!feed::deserialize_atom(feed::serialize(rss.value())),
+                  "rss " + name + ": read as atom");
+        }
+
+        const auto atom =
+            feed::atom::parse_atom(generate(argv[1], "atom", seed), options);
+        check(static_cast<bool>(atom), "atom " + name + ": parse");
+        if (atom) {
+            round_trip(atom.value(), "atom " + name);
+            check(!feed::deserialize_rss(feed::serialize(atom.value())),
+                  "atom " + name + ": read as rss");
+        }
+    }
+
+    std::printf("%d failures\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}
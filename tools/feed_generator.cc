@@ -0,0 +1,701 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Michael Yang
+** Contact: ohmyarchlinux@gmail.com
+**
+** This file is part of the tools of the feed_parser.
+**
+** You may use this file under the terms of the BSD license as follows:
+**
+** "Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are
+** met:
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in
+**     the documentation and/or other materials provided with the
+**     distribution.
+**   * Neither the name of the feed_parser library nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+**
+****************************************************************************/
+
+// Generates synthetic RSS 2.0 and Atom documents for benchmarks and load
+// tests. The output only depends on the options and the seed, so a corpus can
+// be regenerated anywhere instead of being checked in.
+
+#include <boost/program_options.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+struct options {
+    std::string format = "rss";
+    std::uint64_t seed = 0;
+    std::uint64_t items = 20;
+    std::uint64_t target_size = 0; // Keep adding items until reached.
+    std::size_t title_length = 40;
+    std::size_t text_length = 400; // Mean length of description/content.
+    double categories = 2.0;       // Mean number of categories per item.
+    double enclosure_rate = 1.0;
+    double optional_rate = 0.8; // Chance of emitting each optional field.
+    bool itunes = true;
+    bool atom_link = true;
+    std::string time_zones = "all";
+    double cdata_rate = 0.1;
+    double entity_rate = 0.05;
+    double malformed_rate = 0.0;
+};
+
+// std::mt19937_64 is fully specified by the standard while the standard
+// distributions are not, so all draws go through these helpers to keep the
+// output identical across standard libraries.
+class rng {
+  public:
+    explicit rng(std::uint64_t seed) : engine_(seed) {}
+
+    std::uint64_t below(std::uint64_t bound) {
+        return bound == 0 ? 0 : engine_() % bound;
+    }
+    std::uint64_t between(std::uint64_t min, std::uint64_t max) {
+        return min + below(max - min + 1);
+    }
+    bool chance(double probability) {
+        return static_cast<double>(engine_() >> 11) / 9007199254740992.0 <
+               probability;
+    }
+    // Uniform in [0, 2 * mean], which keeps the mean without a distribution.
+    std::uint64_t around(double mean) {
+        return below(static_cast<std::uint64_t>(mean * 2.0) + 1);
+    }
+    template <typename T, std::size_t N> const T &pick(const T (&array)[N]) {
+        return array[below(N)];
+    }
+
+  private:
+    std::mt19937_64 engine_;
+};
+
+// Buffers the document and tracks how many bytes have been produced so that
+// multi-gigabyte outputs never have to be held in memory.
+class writer {
+  public:
+    explicit writer(std::ostream &stream) : stream_(stream) {
+        buffer_.reserve(capacity);
+    }
+    ~writer() { flush(); }
+
+    writer &operator<<(const std::string &str) {
+        buffer_ += str;
+        written_ += str.size();
+        if (buffer_.size() >= capacity)
+            flush();
+
+        return *this;
+    }
+    writer &operator<<(const char *str) { return *this << std::string(str); }
+    writer &operator<<(std::uint64_t number) {
+        return *this << std::to_string(number);
+    }
+
+    void flush() {
+        stream_.write(buffer_.data(),
+                      static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+    std::uint64_t written() const { return written_; }
+
+  private:
+    static const std::size_t capacity = 1 << 20;
+
+    std::ostream &stream_;
+    std::string buffer_;
+    std::uint64_t written_ = 0;
+};
+
+const char *const words[] = {
+    "lorem",   "ipsum",      "dolor",   "sit",      "amet",     "consectetur",
+    "adipiscing", "elit",    "sed",     "do",       "eiusmod",  "tempor",
+    "incididunt", "ut",      "labore",  "et",       "dolore",   "magna",
+    "aliqua",  "feed",       "podcast", "episode",  "release",  "kernel",
+    "update",  "news",       "weekly",  "digest",   "café",     "naïve",
+    "größe",   "日本語",     "新闻",    "привет"};
+
+const char *const entities[] = {"&amp;",   "&lt;b&gt;", "&quot;",
+                                "&apos;",  "&#8217;",   "&#x4E2D;",
+                                "&#169;",  "&gt;"};
+
+const char *const named_zones[] = {"GMT", "UTC", "UT",  "EDT", "EST",
+                                   "CDT", "CST", "MDT", "MST", "PDT",
+                                   "PST"};
+
+const char *const military_zones[] = {"A", "B", "C", "D", "E", "F", "G",
+                                      "H", "I", "K", "L", "M", "N", "O",
+                                      "P", "Q", "R", "S", "T", "U", "V",
+                                      "W", "X", "Y", "Z"};
+
+const char *const week_days[] = {"Thu", "Fri", "Sat", "Sun",
+                                 "Mon", "Tue", "Wed"};
+
+const char *const months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+const char *const skip_days[] = {"Monday", "Tuesday",  "Wednesday", "Thursday",
+                                 "Friday", "Saturday", "Sunday"};
+
+const char *const mime_types[] = {"audio/mpeg", "audio/x-m4a", "video/mp4",
+                                  "image/jpeg", "application/pdf"};
+
+const char *const rels[] = {"alternate", "enclosure", "related", "self",
+                            "via"};
+
+const char *const text_types[] = {"text", "html", "xhtml"};
+
+class generator {
+  public:
+    generator(const options &opts, writer &out)
+        : opts_(opts), random_(opts.seed), out_(out) {}
+
+    void rss() {
+        out_ << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<rss "
+                "version=\"2.0\"";
+        if (opts_.atom_link)
+            out_ << " xmlns:atom=\"http://www.w3.org/2005/Atom\"";
+        if (opts_.itunes)
+            out_ << " xmlns:itunes=\"http://www.itunes.com/dtds/"
+                    "podcast-1.0.dtd\"";
+        out_ << ">\n<channel>\n";
+
+        element("title", words(opts_.title_length));
+        element("link", url("channel"));
+        element("description", text(opts_.text_length));
+        optional("language", "en-us");
+        optional("copyright", "Copyright " + words(20));
+        optional("managingEditor", email());
+        optional("webMaster", email());
+        if (random_.chance(opts_.optional_rate))
+            element("pubDate", rfc822_date());
+        if (random_.chance(opts_.optional_rate))
+            element("lastBuildDate", rfc822_date());
+        for (std::uint64_t i = random_.around(opts_.categories); i != 0; --i)
+            rss_category();
+        optional("generator", "feed_generator " + words(10));
+        optional("docs", "http://www.rssboard.org/rss-specification");
+        if (random_.chance(opts_.optional_rate))
+            out_ << "<cloud domain=\"rpc.example.com\" port=\""
+                 << random_.between(1, 65535) << "\" path=\"/RPC2\" "
+                 << "register_procedure=\"pingMe\" protocol=\""
+                 << (random_.chance(0.5) ? "xml-rpc" : "soap") << "\"/>\n";
+        if (random_.chance(opts_.optional_rate))
+            element("ttl", std::to_string(random_.between(1, 1440)));
+        if (random_.chance(opts_.optional_rate)) {
+            out_ << "<image>\n";
+            element("url", url("logo.png"));
+            element("title", words(opts_.title_length));
+            element("link", url("channel"));
+            optional("width", std::to_string(random_.between(1, 144)));
+            optional("height", std::to_string(random_.between(1, 400)));
+            optional("description", words(opts_.title_length));
+            out_ << "</image>\n";
+        }
+        if (random_.chance(opts_.optional_rate)) {
+            out_ << "<textInput>\n";
+            element("title", words(10));
+            element("description", words(opts_.title_length));
+            element("name", "q");
+            element("link", url("search"));
+            out_ << "</textInput>\n";
+        }
+        if (random_.chance(opts_.optional_rate)) {
+            out_ << "<skipHours>\n";
+            for (std::uint64_t i = random_.between(1, 4); i != 0; --i)
+                element("hour", std::to_string(random_.below(24)));
+            out_ << "</skipHours>\n";
+        }
+        if (random_.chance(opts_.optional_rate)) {
+            out_ << "<skipDays>\n";
+            for (std::uint64_t i = random_.between(1, 3); i != 0; --i)
+                element("day", random_.pick(skip_days));
+            out_ << "</skipDays>\n";
+        }
+        if (opts_.atom_link)
+            out_ << "<atom:link href=\"" << url("feed.xml")
+                 << "\" rel=\"self\" type=\"application/rss+xml\"/>\n";
+        if (opts_.itunes) {
+            if (random_.chance(opts_.optional_rate))
+                element("itunes:new-feed-url", url("new-feed.xml"));
+            out_ << "<itunes:image href=\"" << url("artwork.jpg") << "\"/>\n";
+        }
+
+        for (std::uint64_t i = 0; more(i); ++i)
+            rss_item(i);
+
+        out_ << "</channel>\n</rss>\n";
+    }
+
+    void atom() {
+        out_ << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<feed "
+                "xmlns=\"http://www.w3.org/2005/Atom\">\n";
+
+        element("id", "urn:uuid:" + uuid());
+        text_construct("title", opts_.title_length);
+        element("updated", rfc3339_date());
+        if (random_.chance(opts_.optional_rate))
+            out_ << "<generator uri=\"http://example.com/generator\" "
+                    "version=\"1.0\">feed_generator</generator>\n";
+        optional("icon", url("favicon.ico"));
+        optional("logo", url("logo.png"));
+        if (random_.chance(opts_.optional_rate))
+            text_construct("rights", 20);
+        if (random_.chance(opts_.optional_rate))
+            text_construct("subtitle", opts_.title_length);
+        for (std::uint64_t i = random_.between(1, 2); i != 0; --i)
+            person("author");
+        for (std::uint64_t i = random_.between(1, 3); i != 0; --i)
+            atom_link();
+        for (std::uint64_t i = random_.around(opts_.categories); i != 0; --i)
+            atom_category();
+        for (std::uint64_t i = random_.below(2); i != 0; --i)
+            person("contributor");
+
+        for (std::uint64_t i = 0; more(i); ++i)
+            atom_entry(i);
+
+        out_ << "</feed>\n";
+    }
+
+  private:
+    bool more(std::uint64_t index) const {
+        if (opts_.target_size != 0)
+            return index == 0 || out_.written() < opts_.target_size;
+
+        return index < opts_.items;
+    }
+
+    void rss_item(std::uint64_t index) {
+        const bool malformed = random_.chance(opts_.malformed_rate);
+
+        out_ << "<item>\n";
+        element("title", text(opts_.title_length));
+        element("link", url("item/" + std::to_string(index)));
+        element("description", text(opts_.text_length));
+        optional("author", email());
+        for (std::uint64_t i = random_.around(opts_.categories); i != 0; --i)
+            rss_category();
+        optional("comments", url("item/" + std::to_string(index) + "#c"));
+        if (random_.chance(opts_.enclosure_rate)) {
+            out_ << "<enclosure url=\"" << url("media/" + std::to_string(index))
+                 << "\"";
+            if (random_.chance(opts_.optional_rate))
+                out_ << " length=\"" << random_.between(1, 1ull << 32) << "\"";
+            out_ << " type=\"" << random_.pick(mime_types) << "\"/>\n";
+        }
+        if (random_.chance(opts_.optional_rate)) {
+            const bool perma_link = random_.chance(0.5);
+            out_ << "<guid";
+            if (random_.chance(0.5))
+                out_ << " isPermaLink=\"" << (perma_link ? "true" : "false")
+                     << "\"";
+            out_ << ">"
+                 << (perma_link ? url("item/" + std::to_string(index))
+                                : uuid())
+                 << "</guid>\n";
+        }
+        if (random_.chance(opts_.optional_rate))
+            element("pubDate", rfc822_date());
+        if (random_.chance(opts_.optional_rate))
+            out_ << "<source url=\"" << url("upstream.xml") << "\">"
+                 << words(opts_.title_length) << "</source>\n";
+        if (malformed)
+            defect();
+        out_ << "</item>\n";
+    }
+
+    void atom_entry(std::uint64_t index) {
+        const bool malformed = random_.chance(opts_.malformed_rate);
+
+        out_ << "<entry>\n";
+        element("id", "urn:uuid:" + uuid());
+        text_construct("title", opts_.title_length);
+        element("updated", rfc3339_date());
+        if (random_.chance(opts_.optional_rate))
+            element("published", rfc3339_date());
+        if (random_.chance(opts_.optional_rate))
+            text_construct("content", opts_.text_length);
+        if (random_.chance(opts_.optional_rate))
+            text_construct("summary", opts_.text_length / 4);
+        if (random_.chance(opts_.optional_rate))
+            text_construct("rights", 20);
+        for (std::uint64_t i = random_.below(3); i != 0; --i)
+            person("author");
+        for (std::uint64_t i = random_.between(1, 2); i != 0; --i)
+            atom_link();
+        if (random_.chance(opts_.enclosure_rate))
+            out_ << "<link rel=\"enclosure\" href=\""
+                 << url("media/" + std::to_string(index)) << "\" length=\""
+                 << random_.between(1, 1ull << 32) << "\" type=\""
+                 << random_.pick(mime_types) << "\"/>\n";
+        for (std::uint64_t i = random_.around(opts_.categories); i != 0; --i)
+            atom_category();
+        for (std::uint64_t i = random_.below(2); i != 0; --i)
+            person("contributor");
+        if (malformed)
+            defect();
+        out_ << "</entry>\n";
+    }
+
+    void rss_category() {
+        out_ << "<category";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " domain=\"" << url("categories") << "\"";
+        out_ << ">" << text(12) << "</category>\n";
+    }
+
+    void atom_category() {
+        out_ << "<category term=\"" << words(8) << "\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " scheme=\"" << url("categories") << "\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " label=\"" << words(12) << "\"";
+        out_ << "/>\n";
+    }
+
+    void atom_link() {
+        out_ << "<link href=\"" << url("page/" + uuid()) << "\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " rel=\"" << random_.pick(rels) << "\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " type=\"text/html\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " hreflang=\"en\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " title=\"" << words(16) << "\"";
+        if (random_.chance(opts_.optional_rate))
+            out_ << " length=\"" << random_.between(1, 1 << 20) << "\"";
+        out_ << "/>\n";
+    }
+
+    void person(const char *name) {
+        out_ << "<" << name << ">\n";
+        element("name", words(16));
+        optional("email", email());
+        optional("uri", url("people/" + uuid()));
+        out_ << "</" << name << ">\n";
+    }
+
+    void text_construct(const char *name, std::size_t length) {
+        const char *type = random_.pick(text_types);
+        out_ << "<" << name;
+        if (random_.chance(opts_.optional_rate))
+            out_ << " type=\"" << type << "\"";
+        out_ << ">" << text(length) << "</" << name << ">\n";
+    }
+
+    void element(const std::string &name, const std::string &value) {
+        out_ << "<" << name << ">" << value << "</" << name << ">\n";
+    }
+
+    void optional(const std::string &name, const std::string &value) {
+        if (random_.chance(opts_.optional_rate))
+            element(name, value);
+    }
+
+    // Appends one of the problems seen in real feeds at the end of the
+    // current item or entry.
+    void defect() {
+        switch (random_.below(6)) {
+        case 0: // Unclosed element.
+            out_ << "<title>" << words(10) << "\n";
+            break;
+        case 1: // Bare ampersand.
+            out_ << "<comments>Q&A " << words(10) << "</comments>\n";
+            break;
+        case 2: // Mismatched end tag.
+            out_ << "<author>" << email() << "</auth>\n";
+            break;
+        case 3: // Unparseable date.
+            element("pubDate", "yesterday at " + words(8));
+            break;
+        case 4: // Number out of range.
+            out_ << "<enclosure url=\"" << url("media") << "\" length=\"-"
+                 << random_.below(100) << "\" type=\"audio/mpeg\"/>\n";
+            break;
+        default: // Undefined entity.
+            out_ << "<category>&nbsp;" << words(8) << "</category>\n";
+            break;
+        }
+    }
+
+    std::string words(std::size_t length) {
+        std::string result;
+        while (result.size() < length) {
+            if (!result.empty())
+                result += ' ';
+            result += random_.pick(::words);
+        }
+
+        return result;
+    }
+
+    // Character data that mixes plain words, predefined and numeric entities
+    // and CDATA sections holding markup.
+    std::string text(std::size_t length) {
+        const std::size_t size = static_cast<std::size_t>(
+            random_.between(length / 2, length + length / 2));
+        if (random_.chance(opts_.cdata_rate))
+            return "<![CDATA[<p>" + words(size) + " & <b>more</b></p>]]>";
+
+        std::string result;
+        while (result.size() < size) {
+            if (!result.empty())
+                result += ' ';
+            if (random_.chance(opts_.entity_rate))
+                result += random_.pick(entities);
+            else
+                result += random_.pick(::words);
+        }
+
+        return result;
+    }
+
+    std::string url(const std::string &path) {
+        return "http://feeds" + std::to_string(random_.below(100)) +
+               ".example.com/" + path;
+    }
+
+    std::string email() {
+        return "user" + std::to_string(random_.below(100000)) + "@example.com";
+    }
+
+    std::string uuid() {
+        static const char digits[] = "0123456789abcdef";
+        std::string result;
+        for (int i = 0; i != 32; ++i) {
+            if (i == 8 || i == 12 || i == 16 || i == 20)
+                result += '-';
+            result += digits[random_.below(16)];
+        }
+
+        return result;
+    }
+
+    struct civil {
+        std::int64_t days;
+        std::int64_t year;
+        unsigned month, day, hour, minute, second;
+    };
+
+    // Random instant between 2000 and 2030, split into its civil fields with
+    // Howard Hinnant's days-to-civil algorithm.
+    civil instant() {
+        const std::int64_t seconds =
+            946684800 + static_cast<std::int64_t>(random_.below(946080000));
+        civil result;
+        result.days = seconds / 86400;
+        const std::int64_t time = seconds % 86400;
+        result.hour = static_cast<unsigned>(time / 3600);
+        result.minute = static_cast<unsigned>(time % 3600 / 60);
+        result.second = static_cast<unsigned>(time % 60);
+
+        const std::int64_t z = result.days + 719468;
+        const std::int64_t era = z / 146097;
+        const std::int64_t doe = z - era * 146097;
+        const std::int64_t yoe =
+            (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const std::int64_t mp = (5 * doy + 2) / 153;
+        result.day = static_cast<unsigned>(doy - (153 * mp + 2) / 5 + 1);
+        result.month = static_cast<unsigned>(mp < 10 ? mp + 3 : mp - 9);
+        result.year = yoe + era * 400 + (result.month <= 2);
+
+        return result;
+    }
+
+    std::string zone() {
+        const std::string &mode = opts_.time_zones;
+        const std::uint64_t kind =
+            mode == "numeric" ? 0 : mode == "named"
+                                        ? 1
+                                        : mode == "military"
+                                              ? 2
+                                              : random_.below(3);
+        if (kind == 1)
+            return random_.pick(named_zones);
+        if (kind == 2)
+            return random_.pick(military_zones);
+
+        char offset[6];
+        std::snprintf(offset, sizeof offset, "%c%02u%02u",
+                      random_.chance(0.5) ? '+' : '-',
+                      static_cast<unsigned>(random_.below(13)),
+                      static_cast<unsigned>(random_.below(4) * 15));
+
+        return offset;
+    }
+
+    std::string rfc822_date() {
+        const civil time = instant();
+        char buffer[64];
+        std::snprintf(buffer, sizeof buffer, "%s, %02u %s %04lld %02u:%02u:%02u ",
+                      week_days[time.days % 7], time.day,
+                      months[time.month - 1],
+                      static_cast<long long>(time.year), time.hour,
+                      time.minute, time.second);
+
+        return buffer + zone();
+    }
+
+    std::string rfc3339_date() {
+        const civil time = instant();
+        char buffer[64];
+        std::snprintf(buffer, sizeof buffer, "%04lld-%02u-%02uT%02u:%02u:%02uZ",
+                      static_cast<long long>(time.year), time.month, time.day,
+                      time.hour, time.minute, time.second);
+
+        return buffer;
+    }
+
+    const options &opts_;
+    rng random_;
+    writer &out_;
+};
+
+std::uint64_t parse_size(const std::string &str) {
+    std::size_t end = 0;
+    std::uint64_t size = std::stoull(str, &end);
+    if (end < str.size())
+        switch (str[end]) {
+        case 'k':
+        case 'K':
+            size <<= 10;
+            break;
+        case 'm':
+        case 'M':
+            size <<= 20;
+            break;
+        case 'g':
+        case 'G':
+            size <<= 30;
+            break;
+        default:
+            throw std::invalid_argument("bad size suffix: " + str);
+        }
+
+    return size;
+}
+}
+
+int main(int argc, char *argv[]) {
+    namespace po = boost::program_options;
+
+    options opts;
+    std::string size;
+    std::string output;
+
+    po::options_description description("Options");
+    description.add_options()("help,h", "Print this message.")(
+        "format,f", po::value(&opts.format)->default_value(opts.format),
+        "rss or atom.")("seed,s", po::value(&opts.seed)->default_value(0),
+                        "Seed of the generator, equal seeds give equal "
+                        "documents.")(
+        "items,n", po::value(&opts.items)->default_value(opts.items),
+        "Number of items or entries.")(
+        "size", po::value(&size),
+        "Approximate document size such as 1K, 64M or 4G, overrides items.")(
+        "output,o", po::value(&output), "Output file, stdout by default.")(
+        "title-length",
+        po::value(&opts.title_length)->default_value(opts.title_length),
+        "Length of titles in bytes.")(
+        "text-length",
+        po::value(&opts.text_length)->default_value(opts.text_length),
+        "Mean length of descriptions and contents in bytes.")(
+        "categories",
+        po::value(&opts.categories)->default_value(opts.categories),
+        "Mean number of categories per item.")(
+        "enclosure-rate",
+        po::value(&opts.enclosure_rate)->default_value(opts.enclosure_rate),
+        "Fraction of items with an enclosure.")(
+        "optional-rate",
+        po::value(&opts.optional_rate)->default_value(opts.optional_rate),
+        "Probability of emitting each optional field.")(
+        "itunes", po::value(&opts.itunes)->default_value(opts.itunes),
+        "Declare the iTunes namespace and emit its elements.")(
+        "atom-link", po::value(&opts.atom_link)->default_value(opts.atom_link),
+        "Declare the Atom namespace and emit atom:link.")(
+        "time-zones",
+        po::value(&opts.time_zones)->default_value(opts.time_zones),
+        "Zones of pubDate: numeric, named, military or all.")(
+        "cdata-rate", po::value(&opts.cdata_rate)->default_value(opts.cdata_rate),
+        "Fraction of text fields wrapped in CDATA sections.")(
+        "entity-rate",
+        po::value(&opts.entity_rate)->default_value(opts.entity_rate),
+        "Fraction of words replaced by character references.")(
+        "malformed-rate",
+        po::value(&opts.malformed_rate)->default_value(opts.malformed_rate),
+        "Fraction of items carrying a defect.");
+
+    try {
+        po::variables_map variables;
+        po::store(po::parse_command_line(argc, argv, description), variables);
+        po::notify(variables);
+
+        if (variables.count("help")) {
+            std::cout << "Usage: feed_generator [options]\n" << description;
+
+            return 0;
+        }
+
+        if (opts.format != "rss" && opts.format != "atom")
+            throw std::invalid_argument("unknown format: " + opts.format);
+
+        if (!size.empty())
+            opts.target_size = parse_size(size);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error: cannot open " << output << '\n';
+
+            return 1;
+        }
+    }
+
+    {
+        writer out(output.empty() ? std::cout : file);
+        generator gen(opts, out);
+        if (opts.format == "rss")
+            gen.rss();
+        else
+            gen.atom();
+    }
+
+    return (output.empty() ? std::cout : file).good() ? 0 : 1;
+}